@@ -597,10 +597,6 @@ static void provide_hint(SudokuApp *app) {
         return;
     }
     
-    // Make a backup of the current board
-    int backup[9][9][9];
-    memcpy(backup, app->game->board, sizeof(backup));
-    
     // Create a clean board with only original (clue) cells
     Sudoku clean_game;  // Create a fresh Sudoku instance
     
@@ -615,8 +611,9 @@ static void provide_hint(SudokuApp *app) {
         }
     }
     
-    // Try to solve the puzzle from only the clue cells
-    if (clean_game.Solve() == 0) {
+    // Solve the puzzle from only the clue cells, the exact cover solver
+    // always completes a valid puzzle
+    if (clean_game.SolveExact()) {
         // Collect candidate cells for hints (empty or incorrect cells)
         std::vector<std::pair<int, int>> candidate_cells;
         
@@ -674,9 +671,6 @@ static void provide_hint(SudokuApp *app) {
     } else {
         // Could not solve the puzzle from the original clues
         gtk_label_set_text(GTK_LABEL(app->status_label), "Could not solve the puzzle from its original state");
-        
-        // Restore the backup
-        memcpy(app->game->board, backup, sizeof(backup));
     }
 }
 
@@ -698,10 +692,6 @@ static void check_solution(SudokuApp *app) {
         }
     }
     
-    // Make a backup of the current board
-    int backup[9][9][9];
-    memcpy(backup, app->game->board, sizeof(backup));
-    
     // Create a clean board with only original (clue) cells
     Sudoku clean_game;  // Create a fresh Sudoku instance
     
@@ -716,8 +706,8 @@ static void check_solution(SudokuApp *app) {
         }
     }
     
-    // Try to solve the puzzle from only the clue cells
-    if (clean_game.Solve() != 0) {
+    // Solve the puzzle from only the clue cells
+    if (!clean_game.SolveExact()) {
         gtk_label_set_text(GTK_LABEL(app->status_label), "Could not validate puzzle solution");
         return;
     }
@@ -22,6 +22,7 @@ using namespace std;
 #include <fstream>
 #include <ctime>
 #include <cstring>
+#include <cstdio>
 
 #include "sudoku.h"
 #include "generatepuzzle.h"
@@ -69,6 +70,19 @@ void print_usage() {
     cout << "Usage:" << endl;
     cout << "  sudoku                     - Run in interactive mode" << endl;
     cout << "  sudoku -f <input_file>     - Load and solve puzzle from file" << endl;
+    cout << "  sudoku --stats             - Print solving technique statistics on exit" << endl;
+}
+
+void print_stats(Sudoku& game) {
+    printf("%-22s %8s %8s %10s %8s %12s\n",
+           "Technique", "Calls", "Success", "Eliminated", "Placed", "Time (us)");
+    for (int t = 0; t < TECH_COUNT; t++) {
+        SolveTechnique technique = static_cast<SolveTechnique>(t);
+        const TechniqueStats& stats = game.GetTechniqueStats(technique);
+        printf("%-22s %8lld %8lld %10lld %8lld %12.1f\n",
+               SolvePipeline::Name(technique), stats.calls, stats.successes,
+               stats.eliminated, stats.placed, stats.nanoseconds / 1000.0);
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -80,6 +94,7 @@ int main(int argc, char* argv[]) {
     // Parse command line arguments
     string input_file = "";
     string output_file = "";
+    bool show_stats = false;
     
     for (int i = 1; i < argc; i++) {
         string arg = argv[i];
@@ -93,6 +108,9 @@ int main(int argc, char* argv[]) {
         else if (arg == "-o" && i + 1 < argc) {
             output_file = argv[++i];
         }
+        else if (arg == "--stats") {
+            show_stats = true;
+        }
     }
     
     // If input file specified, run in command line mode
@@ -255,61 +273,62 @@ int main(int argc, char* argv[]) {
         break;
       case 'Q':
         endwin();
+        if (show_stats) print_stats(NewGame);
         return 0;
       case 'S':  // Standard elimination
         NewGame.LogBoard(logfile, "Standard Elim Before");
-        NewGame.StdElim();
+        NewGame.RunTechnique(TECH_STD_ELIM);
         NewGame.LogBoard(logfile, "Standard Elim After");
         break;
       case 'L':  // Line elimination
         NewGame.LogBoard(logfile, "Line Elim Before");
-        NewGame.LinElim();
+        NewGame.RunTechnique(TECH_LINE_ELIM);
         NewGame.LogBoard(logfile, "Line Elim After");
         break;
       case 'C':  // Standard elimination
         NewGame.LogBoard(logfile, "Find Simple Coloring Before");
-        NewGame.FindSimpleColoring();
+        NewGame.RunTechnique(TECH_SIMPLE_COLORING);
         NewGame.LogBoard(logfile, "Find Simple Coloring After");
         break;
       case 'I':  // Hidden pairs
         NewGame.LogBoard(logfile, "Find Hidden Pairs Before");
-        NewGame.FindHiddenPairs();
+        NewGame.RunTechnique(TECH_HIDDEN_PAIRS);
         NewGame.LogBoard(logfile, "Find Hidden Pairs After");
         break;
       case 'P':  // Pointing pairs
         NewGame.LogBoard(logfile, "Find Pointing Pairs Before");
-        NewGame.FindPointingPairs();
+        NewGame.RunTechnique(TECH_POINTING_PAIRS);
         NewGame.LogBoard(logfile, "Find Pointing Pairs After");
         break;
       case 'X':  // X-Wing
         NewGame.LogBoard(logfile, "Find XWING Before");
-        NewGame.FindXWing();
+        NewGame.RunTechnique(TECH_X_WING);
         NewGame.LogBoard(logfile, "Find XWING After");
         break;
-      case 'Y':  // XY-Wing (Broken)
+      case 'Y':  // XY-Wing
         NewGame.LogBoard(logfile, "Find XYWING Before");
-        NewGame.FindXYWing();
+        NewGame.RunTechnique(TECH_XY_WING);
         NewGame.LogBoard(logfile, "Find XYWING After");
         break;
-      case ';':  // XYZ-Wing (Broken)
+      case ';':  // XYZ-Wing
         NewGame.LogBoard(logfile, "Find XYZWING Before");
-        NewGame.FindXYZWing();
+        NewGame.RunTechnique(TECH_XYZ_WING);
         NewGame.LogBoard(logfile, "Find XYZWING After");
         break;
       case 'F':  // Swordfish
         NewGame.LogBoard(logfile, "Find Swordfish Before");
-        NewGame.FindSwordFish();
+        NewGame.RunTechnique(TECH_SWORDFISH);
         NewGame.LogBoard(logfile, "Find Swordfish After");
         break;
       case 'N':  // Hidden singles
         NewGame.LogBoard(logfile, "Find Hidden Singles Before");
-        NewGame.FindHiddenSingles();
+        NewGame.RunTechnique(TECH_HIDDEN_SINGLES);
         NewGame.LogBoard(logfile, "Find Hidden Singles After");
 
         break;
       case 'K':  // Naked sets
         NewGame.LogBoard(logfile, "Find Naked Sets Before");
-        NewGame.FindNakedSets();
+        NewGame.RunTechnique(TECH_NAKED_SETS);
         NewGame.LogBoard(logfile, "Find Naked Sets After");
 
         break;
@@ -455,6 +474,8 @@ int main(int argc, char* argv[]) {
         }
         break;
     }
+    // Show the latest solving steps in the debug lines below the grid
+    NewGame.ShowTrace(10);
     move(0,0);
     refresh();
   }
@@ -5,12 +5,12 @@
 
 PuzzleGenerator::PuzzleGenerator(Sudoku& s) : sudoku(s), 
     difficultyLevels{
-        {"easy",    {50, 55, false, false, false, false     }},
-        {"medium",  {36, 49, false, false, false, false     }},
-        {"hard",    {32, 35, true,  false, false, false     }},
-        {"expert",  {28, 31, true,  true,  true,  false     }},
-        {"extreme", {24, 27, true,  true,  true,  true      }},
-        {"ultraextreme", {17, 19, true,  true,  true,  true }}
+        {"easy",    {50, 55, 0.0, 1.5  }},
+        {"medium",  {28, 35, 1.6, 2.6  }},
+        {"hard",    {25, 31, 2.7, 3.4  }},
+        {"expert",  {25, 28, 3.5, 4.4  }},
+        {"extreme", {24, 27, 4.5, 7.0  }},
+        {"ultraextreme", {17, 23, 7.1, 8.5 }}
 
     } {
     rng.seed(std::chrono::steady_clock::now().time_since_epoch().count());
@@ -30,8 +30,10 @@ bool PuzzleGenerator::generateValidSolution() {
         }
         std::shuffle(positions.begin(), positions.end(), rng);
         
-        // Try to place up to 50 valid numbers
-        for (int placed = 0; placed < 50; placed++) {
+        // Seed a handful of random valid numbers, the exact cover solver
+        // completes the rest of the grid
+        bool seeded = true;
+        for (int placed = 0; placed < 11; placed++) {
             int row = positions[placed].first;
             int col = positions[placed].second;
             
@@ -45,30 +47,16 @@ bool PuzzleGenerator::generateValidSolution() {
             }
             
             if (!foundValid) {
-                sudoku.print_debug("Attempt failed, starting over...\n");               
-                break;  // Try a new board
-            }
-            
-            // After each valid placement, try solving
-            if (sudoku.Solve() == 0) {
-                // Check if we have all 81 numbers
-                bool allFilled = true;
-                for (int i = 0; i < 9 && allFilled; i++) {
-                    for (int j = 0; j < 9; j++) {
-                        if (sudoku.GetValue(i, j) == -1) {
-                            allFilled = false;
-                            break;
-                        }
-                    }
-                }
-                
-                if (allFilled && sudoku.IsValidSolution()) {
-                    sudoku.print_debug("Success, created a unique solution...\n");
-                    return true;  // Found a complete valid solution!
-                }
+                seeded = false;
+                break;
             }
         }
-        sudoku.print_debug("Attempt failed after 50 placments, starting over...\n");
+
+        if (seeded && sudoku.SolveExact() && sudoku.IsValidSolution()) {
+            sudoku.print_debug("Success, created a unique solution...\n");
+            return true;  // Found a complete valid solution!
+        }
+        sudoku.print_debug("Attempt failed, starting over...\n");
         // If we get here, try again from the start
     }
 }
@@ -92,31 +80,23 @@ bool PuzzleGenerator::generatePuzzle(const std::string& difficulty) {
     // Generate one valid solution - will always succeed
     generateValidSolution();
 
-    // Store the complete solution
-    int solution[9][9][9];
-    memcpy(solution, sudoku.board, sizeof(solution));
-
-    // Calculate how many numbers to remove based on difficulty
-    int numbersToRemove;
-    if (difficulty == "easy") {
-        numbersToRemove = 31;
-    } else if (difficulty == "medium") {
-        numbersToRemove = 45;
-    } else if (difficulty == "hard") {
-        numbersToRemove = 49;
-    } else if (difficulty == "expert") {
-        numbersToRemove = 53;
-    } else if (difficulty == "extreme") {
-        numbersToRemove = 57;
-    } else if (difficulty == "ultraextreme") {
-        numbersToRemove = 64;
-    } else { // extreme
-        numbersToRemove = 57;
-    }
-
-    while (true) {
+    // Mark the complete solution, each attempt rolls back to it
+    size_t solution = sudoku.Mark();
+
+    // Remove clues down to the level's minimum
+    const DifficultySettings& settings = diffIt->second;
+    int numbersToRemove = 81 - settings.minClues;
+
+    // Remove clues one at a time, keeping only removals that leave a single
+    // solution. A clue that fails once can't be removed later in the same
+    // pass, since clearing more cells only adds solutions.
+    const int maxAttempts = 100;
+    std::vector<std::pair<int, int>> bestRemoved;
+    double bestDistance = 0;
+    int bestExcess = 0;
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
         // Restore the complete solution
-        memcpy(sudoku.board, solution, sizeof(solution));
+        sudoku.Rollback(solution);
 
         // Create list of all positions
         std::vector<std::pair<int, int>> positions;
@@ -127,45 +107,69 @@ bool PuzzleGenerator::generatePuzzle(const std::string& difficulty) {
         }
         std::shuffle(positions.begin(), positions.end(), rng);
 
-        // Remove the specified number of random positions
-        for (int i = 0; i < numbersToRemove; i++) {
-            int row = positions[i].first;
-            int col = positions[i].second;
-            sudoku.ClearValue(row, col);
-        }
-
-        // Try to solve the puzzle
-        if (sudoku.Solve() == 0) {
-            // Verify all cells are filled
-            bool allFilled = true;
-            for (int i = 0; i < 9 && allFilled; i++) {
-                for (int j = 0; j < 9; j++) {
-                    if (sudoku.GetValue(i, j) == -1) {
-                        allFilled = false;
-                        break;
-                    }
-                }
+        std::vector<std::pair<int, int>> removed;
+        for (size_t i = 0; i < positions.size() && (int)removed.size() < numbersToRemove; i++) {
+            removed.push_back(positions[i]);
+            if (!isUnique(removed)) {
+                removed.pop_back();
             }
+        }
 
-            if (allFilled) {
-                // Success - restore to unsolved state
-                memcpy(sudoku.board, solution, sizeof(solution));
-                for (int i = 0; i < numbersToRemove; i++) {
-                    int row = positions[i].first;
-                    int col = positions[i].second;
-                    sudoku.ClearValue(row, col);
-                }
-                return true;
-            }
+        // Rate the puzzle with the logic techniques
+        for (const auto& cell : removed) {
+            sudoku.ClearValue(cell.first, cell.second);
         }
-        // If we get here, try another removal pattern
+        Rating rating = sudoku.Rate();
+
+        // How far the score is from the level's band, with a puzzle the
+        // techniques can't finish counting most. Clues over the range only
+        // break ties between equally distant puzzles.
+        double distance = 0;
+        int clues = 81 - (int)removed.size();
+        if (!rating.solved) distance += 1000;
+        if (rating.score < settings.minScore) distance += settings.minScore - rating.score;
+        if (rating.score > settings.maxScore) distance += rating.score - settings.maxScore;
+        int excess = std::max(0, clues - settings.maxClues);
+
+        if (bestRemoved.empty() || distance < bestDistance ||
+            (distance == bestDistance && excess < bestExcess)) {
+            bestRemoved = removed;
+            bestDistance = distance;
+            bestExcess = excess;
+        }
+        if (distance == 0 && excess == 0) break;
+    }
+
+    if ((int)bestRemoved.size() < numbersToRemove) {
+        sudoku.print_debug("Could only remove %d of %d numbers and keep the solution unique\n",
+                           (int)bestRemoved.size(), numbersToRemove);
+    }
+
+    // Restore to unsolved state
+    sudoku.Rollback(solution);
+    sudoku.Commit();
+    for (const auto& cell : bestRemoved) {
+        sudoku.ClearValue(cell.first, cell.second);
+    }
+    return true;
+}
+
+// Check that the complete board with removedCells cleared has one solution
+bool PuzzleGenerator::isUnique(const std::vector<std::pair<int, int>>& removedCells) {
+    size_t mark = sudoku.Mark();
+    for (const auto& cell : removedCells) {
+        sudoku.ClearValue(cell.first, cell.second);
     }
+    // Stops as soon as a second solution turns up
+    bool unique = sudoku.CountSolutions(2) == 1;
+    sudoku.Rollback(mark);
+    sudoku.Commit();
+    return unique;
 }
 
 // Helper methods remain the same
 bool PuzzleGenerator::requiresAdvancedTechnique(const std::string& technique) {
-    int backup[9][9][9];
-    memcpy(backup, sudoku.board, sizeof(backup));
+    size_t mark = sudoku.Mark();
 
     int result;
     do {
@@ -193,6 +197,7 @@ bool PuzzleGenerator::requiresAdvancedTechnique(const std::string& technique) {
     } while (result > 0);
 
     bool needsTechnique = !sudoku.IsValidSolution();
-    memcpy(sudoku.board, backup, sizeof(backup));
+    sudoku.Rollback(mark);
+    sudoku.Commit();
     return needsTechnique;
 }
@@ -18,10 +18,8 @@ private:
     struct DifficultySettings {
         int minClues;      // Minimum number of starting clues
         int maxClues;      // Maximum number of starting clues
-        bool allowXWing;   // Whether X-Wing technique is needed
-        bool allowSwordfish; // Whether Swordfish technique is needed
-        bool allowXYWing;   // Whether XY-Wing technique is needed
-        bool allowXYZWing;  // Whether XYZ-Wing technique is needed
+        double minScore;   // Range of Sudoku::Rate() scores for the level
+        double maxScore;
     };
 
     const std::map<std::string, DifficultySettings> difficultyLevels;
@@ -359,6 +359,8 @@ int main(int argc, char *argv[]) {
       if (need_redraw) {
         draw_screen(NewGame, x_pos, y_pos);
       }
+      // The debug line holds one message: the latest solving step
+      NewGame.ShowTrace(1);
     }
   }
   return 0;
@@ -13,7 +13,7 @@ if sys.platform == "win32":
     # Optionally add static runtime
     # extra_compile_args.extend(['/MT'])
 else:
-    extra_compile_args = ['-std=c++11', '-O3']
+    extra_compile_args = ['-std=c++14', '-O3']
     if sys.platform == "darwin":
         extra_compile_args.extend(['-stdlib=libc++'])
 
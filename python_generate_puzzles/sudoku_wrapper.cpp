@@ -6,6 +6,61 @@
 namespace py = pybind11;
 
 PYBIND11_MODULE(sudoku_solver, m) {
+    py::enum_<SolveTechnique>(m, "SolveTechnique")
+        .value("STD_ELIM", TECH_STD_ELIM)
+        .value("LINE_ELIM", TECH_LINE_ELIM)
+        .value("HIDDEN_SINGLES", TECH_HIDDEN_SINGLES)
+        .value("HIDDEN_PAIRS", TECH_HIDDEN_PAIRS)
+        .value("POINTING_PAIRS", TECH_POINTING_PAIRS)
+        .value("X_WING", TECH_X_WING)
+        .value("SWORDFISH", TECH_SWORDFISH)
+        .value("JELLYFISH", TECH_JELLYFISH)
+        .value("NAKED_SETS", TECH_NAKED_SETS)
+        .value("HIDDEN_SETS", TECH_HIDDEN_SETS)
+        .value("XY_WING", TECH_XY_WING)
+        .value("XYZ_WING", TECH_XYZ_WING)
+        .value("FINNED_FISH", TECH_FINNED_FISH)
+        .value("SIMPLE_COLORING", TECH_SIMPLE_COLORING)
+        .value("CHAINS", TECH_CHAINS)
+        .value("ALS_XZ", TECH_ALS_XZ)
+        .value("ALS_XY_WING", TECH_ALS_XY_WING)
+        .value("NISHIO", TECH_NISHIO);
+
+    py::class_<SolvePipeline> pipeline(m, "SolvePipeline");
+    py::enum_<SolvePipeline::RestartPolicy>(pipeline, "RestartPolicy")
+        .value("RESTART_CHEAPEST", SolvePipeline::RESTART_CHEAPEST)
+        .value("CONTINUE", SolvePipeline::CONTINUE);
+    pipeline
+        .def(py::init<>())
+        .def("clear", &SolvePipeline::Clear)
+        .def("add", &SolvePipeline::Add)
+        .def("remove", &SolvePipeline::Remove)
+        .def("contains", &SolvePipeline::Contains)
+        .def("size", &SolvePipeline::Size)
+        .def("at", &SolvePipeline::At)
+        .def("set_restart_policy", &SolvePipeline::SetRestartPolicy)
+        .def("get_restart_policy", &SolvePipeline::GetRestartPolicy)
+        .def("set_adaptive", &SolvePipeline::SetAdaptive)
+        .def("is_adaptive", &SolvePipeline::IsAdaptive)
+        .def("reset_statistics", &SolvePipeline::ResetStatistics)
+        .def_static("name", &SolvePipeline::Name)
+        .def_static("difficulty", &SolvePipeline::Difficulty);
+
+    py::class_<TechniqueStats>(m, "TechniqueStats")
+        .def_readonly("calls", &TechniqueStats::calls)
+        .def_readonly("successes", &TechniqueStats::successes)
+        .def_readonly("eliminated", &TechniqueStats::eliminated)
+        .def_readonly("placed", &TechniqueStats::placed)
+        .def_readonly("nanoseconds", &TechniqueStats::nanoseconds);
+
+    py::class_<Rating>(m, "Rating")
+        .def_readonly("solved", &Rating::solved)
+        .def_readonly("hardest", &Rating::hardest)
+        .def_readonly("score", &Rating::score)
+        .def_property_readonly("steps", [](const Rating& rating) {
+            return std::vector<int>(rating.steps, rating.steps + TECH_COUNT);
+        });
+
     py::class_<Sudoku>(m, "Sudoku")
         // Constructor
         .def(py::init<>())
@@ -19,10 +74,22 @@ PYBIND11_MODULE(sudoku_solver, m) {
         .def("save_to_file", &Sudoku::SaveToFile)
         
         // Main Solving Functions
-        .def("solve", &Sudoku::Solve)
+        .def("solve", py::overload_cast<>(&Sudoku::Solve))
+        .def("solve", py::overload_cast<SolvePipeline&>(&Sudoku::Solve))
+        .def("run_technique", &Sudoku::RunTechnique)
         .def("solve_basic", &Sudoku::SolveBasic)
+        .def("solve_singles", &Sudoku::SolveSingles)
+        .def("rate", &Sudoku::Rate)
+        .def("set_search_fallback", &Sudoku::SetSearchFallback)
+        .def("solve_exact", &Sudoku::SolveExact)
+        .def("count_solutions", &Sudoku::CountSolutions)
+        .def("is_solved", &Sudoku::IsSolved)
         .def("legal_value", &Sudoku::LegalValue)
         .def("is_valid_solution", &Sudoku::IsValidSolution)
+
+        // Profiling
+        .def("get_technique_stats", &Sudoku::GetTechniqueStats, py::return_value_policy::copy)
+        .def("reset_technique_stats", &Sudoku::ResetTechniqueStats)
         
         // Debug and Logging
         .def("log_board", &Sudoku::LogBoard)
@@ -37,13 +104,22 @@ PYBIND11_MODULE(sudoku_solver, m) {
         .def("find_hidden_pairs", &Sudoku::FindHiddenPairs)
         .def("find_pointing_pairs", &Sudoku::FindPointingPairs)
         .def("find_naked_sets", &Sudoku::FindNakedSets)
+        .def("find_hidden_sets", &Sudoku::FindHiddenSets)
+        .def("find_subsets", &Sudoku::FindSubsets)
         
         // Expert Solving Techniques
         .def("find_x_wing", &Sudoku::FindXWing)
         .def("find_sword_fish", &Sudoku::FindSwordFish)
+        .def("find_jellyfish", &Sudoku::FindJellyfish)
+        .def("find_finned_fish", &Sudoku::FindFinnedFish)
+        .def("find_fish", &Sudoku::FindFish)
         .def("find_xy_wing", &Sudoku::FindXYWing)
         .def("find_xyz_wing", &Sudoku::FindXYZWing)
         .def("find_simple_coloring", &Sudoku::FindSimpleColoring)
+        .def("find_chains", &Sudoku::FindChains)
+        .def("find_als_xz", &Sudoku::FindAlsXZ)
+        .def("find_als_xy_wing", &Sudoku::FindAlsXYWing)
+        .def("find_nishio", &Sudoku::FindNishio)
         .def("clean", &Sudoku::Clean)
         
         // Export Functions
@@ -1,18 +1,40 @@
 #include <iostream>
 using namespace std;
 #include <stdlib.h>
+#include <stdio.h>
 
 #include <vector>
-#include <set>
-#include <algorithm>
 
 #include <fstream>
 #include <ctime>
 #include <cstring>
+#include <memory>
+#include <chrono>
+#include <algorithm>
 #include "sudoku.h"
 
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SUDOKU_SSE2
+#endif
+
+// Symbols for values in puzzle files: 1-9, then A, B, ... on larger grids
+static inline char ValueChar(int value)
+{
+    return value < 9 ? '1' + value : 'A' + value - 9;
+}
+
+static inline int CharValue(char c)
+{
+    if (c >= '1' && c <= '9') return c - '1';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 9;
+    if (c >= 'a' && c <= 'z') return c - 'a' + 9;
+    return -1;
+}
+
 // Implementation of new file loading functions
-bool Sudoku::LoadFromFile(const string& filename) {
+template<int Box>
+bool BasicSudoku<Box>::LoadFromFile(const string& filename) {
     ifstream file(filename);
     if (!file.is_open()) {
         cerr << "Error: Could not open file " << filename << endl;
@@ -25,13 +47,13 @@ bool Sudoku::LoadFromFile(const string& filename) {
     string line;
     int row = 0;
     
-    while (getline(file, line) && row < 9) {
-        if (line.length() < 9) continue;  // Skip short lines
+    while (getline(file, line) && row < N) {
+        if (line.length() < (size_t)N) continue;  // Skip short lines
         
-        for (int col = 0; col < 9; col++) {
-            char c = line[col];
-            if (c >= '1' && c <= '9') {
-                SetValue(col, row, c - '1');
+        for (int col = 0; col < N; col++) {
+            int value = CharValue(line[col]);
+            if (value >= 0 && value < N) {
+                SetValue(col, row, value);
             }
             // Skip spaces, dots, and zeros
         }
@@ -39,21 +61,22 @@ bool Sudoku::LoadFromFile(const string& filename) {
     }
     
     file.close();
-    return row == 9;  // Return true if we read all 9 rows
+    return row == N;  // Return true if we read all N rows
 }
 
-void Sudoku::SaveToFile(const string& filename) {
+template<int Box>
+void BasicSudoku<Box>::SaveToFile(const string& filename) {
     ofstream file(filename);
     if (!file.is_open()) {
         cerr << "Error: Could not create file " << filename << endl;
         return;
     }
     
-    for (int row = 0; row < 9; row++) {
-        for (int col = 0; col < 9; col++) {
+    for (int row = 0; row < N; row++) {
+        for (int col = 0; col < N; col++) {
             int val = GetValue(col, row);
-            if (val >= 0 && val <= 8) {
-                file << (val + 1);
+            if (val >= 0 && val < N) {
+                file << ValueChar(val);
             } else {
                 file << '.';
             }
@@ -66,112 +89,539 @@ void Sudoku::SaveToFile(const string& filename) {
 
 
 
-Sudoku::Sudoku()
+// Bit helpers for the candidate masks
+static inline int BitCount(unsigned long long mask)
 {
-  int x, y, k;
-  for(x=0;x<9;x++)
+#if defined(__GNUC__)
+  return mask >> 32 ? __builtin_popcountll(mask) : __builtin_popcount((unsigned int)mask);
+#else
+  int count = 0;
+  for(; mask; mask &= mask - 1) count++;
+  return count;
+#endif
+}
+
+static inline int LowestBit(unsigned long long mask)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(mask);
+#else
+  int bit = 0;
+  while(!(mask & 1)) { mask >>= 1; bit++; }
+  return bit;
+#endif
+}
+
+// The next larger mask with the same number of bits set (Gosper's hack)
+static inline unsigned long long NextCombination(unsigned long long combo)
+{
+  unsigned long long low = combo & (~combo + 1);
+  unsigned long long ripple = combo + low;
+  return ripple | (((combo ^ ripple) >> 2) / low);
+}
+
+// Value held by a cell mask, or -1 unless exactly one candidate is left
+static inline int MaskValue(unsigned long long mask)
+{
+  return (mask && !(mask & (mask - 1))) ? LowestBit(mask) : -1;
+}
+
+// Bits needed to count from 0 to n
+static constexpr int CountBits(int n)
+{
+  return n ? 1 + CountBits(n >> 1) : 0;
+}
+
+// Set of cells, one bit per cell in 64-bit words
+template<int Cells>
+struct CellSet
+{
+  static const int WORDS = (Cells + 63) / 64;
+  unsigned long long words[WORDS];
+
+  bool Has(int cell) const { return (words[cell >> 6] >> (cell & 63)) & 1; }
+  void Add(int cell) { words[cell >> 6] |= 1ULL << (cell & 63); }
+};
+
+// Fixed geometry of the grid. Cells are numbered x * N + y and units are
+// rows (first coordinate) 0..N-1, columns N..2N-1, then boxes. Peers and the
+// sees sets list the other cells sharing a unit, peers in ascending order;
+// unitSets hold the cells of each unit.
+template<int Box>
+struct GridTables
+{
+  static const int N = Box * Box;
+  static const int CELLS = N * N;
+  static const int PEERS = 2 * (N - 1) + (Box - 1) * (Box - 1);
+  typedef typename std::conditional<(CELLS <= 256), unsigned char, unsigned short>::type Index;
+
+  Index unitCells[3 * N][N];
+  Index cellUnits[CELLS][3];
+  Index peers[CELLS][PEERS];
+  CellSet<CELLS> sees[CELLS];
+  CellSet<CELLS> unitSets[3 * N];
+};
+
+template<int Box>
+static constexpr GridTables<Box> BuildGridTables()
+{
+  const int N = Box * Box;
+  GridTables<Box> t{};
+  for(int cell = 0; cell < N * N; cell++)
+  {
+    int x = cell / N, y = cell % N;
+    t.cellUnits[cell][0] = x;
+    t.cellUnits[cell][1] = N + y;
+    t.cellUnits[cell][2] = 2 * N + (x / Box) * Box + y / Box;
+  }
+  for(int i = 0; i < N; i++)
+  {
+    for(int unit = 0; unit < N; unit++)
+    {
+      t.unitCells[unit][i] = unit * N + i;
+      t.unitCells[N + unit][i] = i * N + unit;
+      t.unitCells[2 * N + unit][i] = ((unit / Box) * Box + i / Box) * N + (unit % Box) * Box + i % Box;
+    }
+  }
+  for(int unit = 0; unit < 3 * N; unit++)
+  {
+    for(int i = 0; i < N; i++)
+    {
+      int cell = t.unitCells[unit][i];
+      t.unitSets[unit].words[cell >> 6] |= 1ULL << (cell & 63);
+    }
+  }
+  // Walk the grid row by row so the peers come out in ascending order: the
+  // whole of the cell's own row, the box part of the rows in its band, and
+  // the cell's column everywhere else
+  for(int cell = 0; cell < N * N; cell++)
+  {
+    int x = cell / N, y = cell % N;
+    int n = 0;
+    for(int row = 0; row < N; row++)
+    {
+      for(int col = 0; col < N; col++)
+      {
+        bool peer = row == x ? col != y
+                  : row / Box == x / Box ? col / Box == y / Box
+                  : col == y;
+        if(!peer) continue;
+        int other = row * N + col;
+        t.peers[cell][n++] = other;
+        t.sees[cell].words[other >> 6] |= 1ULL << (other & 63);
+      }
+    }
+  }
+  return t;
+}
+
+template<int Box>
+static constexpr GridTables<Box> GRID = BuildGridTables<Box>();
+
+// True when two different cells share a row, column or box
+template<int Box>
+static inline bool Sees(int a, int b)
+{
+  return GRID<Box>.sees[a].Has(b);
+}
+
+// Open cells grouped by candidate mask, so the cells with a given mask that
+// see some cell are one intersection with its sees set. Masks are kept
+// sorted for the lookup; there can't be more groups than cells.
+template<int Cells, typename Mask>
+struct CellGroups
+{
+  Mask masks[Cells];
+  CellSet<Cells> cells[Cells];
+  CellSet<Cells> all = {};
+  int count = 0;
+
+  void Add(int cell, Mask mask)
+  {
+    all.Add(cell);
+    int i = std::lower_bound(masks, masks + count, mask) - masks;
+    if(i == count || masks[i] != mask)
+    {
+      std::copy_backward(masks + i, masks + count, masks + count + 1);
+      std::copy_backward(cells + i, cells + count, cells + count + 1);
+      masks[i] = mask;
+      cells[i] = CellSet<Cells>();
+      count++;
+    }
+    cells[i].Add(cell);
+  }
+
+  const CellSet<Cells>* Find(Mask mask) const
+  {
+    int i = std::lower_bound(masks, masks + count, mask) - masks;
+    return (i < count && masks[i] == mask) ? &cells[i] : nullptr;
+  }
+};
+
+// Call visit on every cell in all of the given sets
+template<int Cells, typename Visit>
+static inline void ForEachCell(std::initializer_list<const CellSet<Cells>*> sets, Visit visit)
+{
+  for(int w = 0; w < CellSet<Cells>::WORDS; w++)
+  {
+    unsigned long long bits = ~0ULL;
+    for(const CellSet<Cells>* set : sets) bits &= set->words[w];
+    for(; bits; bits &= bits - 1) visit(w * 64 + LowestBit(bits));
+  }
+}
+
+// Add up the N cell masks of every unit into bit planes: bit v of
+// planes[k][unit] is bit k of the number of cells in the unit that allow v.
+// Each step is a ripple carry add done for all N values at once.
+template<typename Mask, int N, int PLANES, int LANES>
+static void CountUnitPlanes(const Mask (&lanes)[N][LANES], Mask (&planes)[PLANES][LANES])
+{
+  for(int unit = 0; unit < LANES; unit++)
+  {
+    Mask bits[PLANES] = {};
+    for(int i = 0; i < N; i++)
+    {
+      Mask carry = lanes[i][unit];
+      for(int k = 0; k < PLANES; k++)
+      {
+        Mask next = bits[k] & carry;
+        bits[k] ^= carry;
+        carry = next;
+      }
+    }
+    for(int k = 0; k < PLANES; k++)
+    {
+      planes[k][unit] = bits[k];
+    }
+  }
+}
+
+#ifdef SUDOKU_SSE2
+// 16-bit masks (9x9 and 16x16) go eight units to a register
+template<int N, int PLANES, int LANES>
+static void CountUnitPlanes(const unsigned short (&lanes)[N][LANES], unsigned short (&planes)[PLANES][LANES])
+{
+  for(int block = 0; block < LANES; block += 8)
   {
-    for(y=0;y<9;y++)
+    __m128i bits[PLANES];
+    for(int k = 0; k < PLANES; k++)
+    {
+      bits[k] = _mm_setzero_si128();
+    }
+    for(int i = 0; i < N; i++)
     {
-      for(k=0;k<9;k++)
+      __m128i carry = _mm_load_si128((const __m128i*)&lanes[i][block]);
+      for(int k = 0; k < PLANES; k++)
       {
-	board[x][y][k]=k;
+        __m128i next = _mm_and_si128(bits[k], carry);
+        bits[k] = _mm_xor_si128(bits[k], carry);
+        carry = next;
       }
     }
+    for(int k = 0; k < PLANES; k++)
+    {
+      _mm_store_si128((__m128i*)&planes[k][block], bits[k]);
+    }
+  }
+}
+#endif
+
+template<int Box>
+BasicSudoku<Box>::BasicSudoku()
+{
+  int i;
+  for(i=0;i<CELLS;i++)
+  {
+    board.cells[i]=ALL_CANDIDATES;
+  }
+  for(i=0;i<UNITS;i++)
+  {
+    board.used[i]=0;
+    for(int k=0;k<N;k++)
+    {
+      board.counts[i][k]=0;
+    }
   }
+  board.conflicts=0;
+  board.filled=0;
+  board.synced=true;
+  propagation=false;
+  pendingCount=0;
+  searchFallback=false;
+  trailing=false;
+  marks=0;
+  trailSize=0;
+  eliminations=0;
+  placements=0;
+  ResetTechniqueStats();
+
+  // Solving makes no allocations of its own
+  trail.Allocate();
+  alsIndex.Allocate();
+  chainIndex.Allocate();
+}
+
+template<int Box>
+BasicSudoku<Box>::~BasicSudoku()
+{
+
+}
+
+// Large grids have no debug console of their own; Sudoku sends this to the
+// platform's output
+template<int Box>
+void BasicSudoku<Box>::print_debug(const char*, ...)
+{
 }
 
-Sudoku::~Sudoku()
+// Render one trace event as a line of text, coordinates counted from 1
+template<int Box>
+int BasicSudoku<Box>::FormatTraceEvent(const TraceEvent& event, char* buffer, int size)
 {
+  const char* name = SolvePipeline::Name(static_cast<SolveTechnique>(event.technique));
+  int x = event.cell / N + 1, y = event.cell % N + 1;
+  int length;
+  switch(event.kind)
+  {
+    case TRACE_PLACE:
+      length = snprintf(buffer, size, "%s: placed %c at (%d,%d)", name, ValueChar(event.value), x, y);
+      break;
+    case TRACE_ELIMINATE:
+      length = snprintf(buffer, size, "%s: eliminated %c from (%d,%d)", name, ValueChar(event.value), x, y);
+      break;
+    case TRACE_PATTERN:
+      length = snprintf(buffer, size, "%s: found on %c at (%d,%d)", name, ValueChar(event.value), x, y);
+      break;
+    default:
+      return snprintf(buffer, size, event.value > 0 ? "%s: %d changes" : "%s: no progress",
+                      name, event.value);
+  }
+  if(event.reason && length >= 0 && length < size)
+  {
+    length += snprintf(buffer + length, size - length, " - %s", event.reason);
+  }
+  if(event.source >= 0 && length >= 0 && length < size)
+  {
+    length += snprintf(buffer + length, size - length, " (%d,%d)", event.source / N + 1, event.source % N + 1);
+  }
+  return length;
+}
 
+template<int Box>
+void BasicSudoku<Box>::ShowTrace(int limit)
+{
+  char buffer[256];
+  int first = trace.Size() > limit ? trace.Size() - limit : 0;
+  for(int i = first; i < trace.Size(); i++)
+  {
+    FormatTraceEvent(trace.At(i), buffer, sizeof(buffer));
+    print_debug("%s\n", buffer);
+  }
+  trace.Clear();
 }
 
 // Add implementation
 int Sudoku::debug_line = 0;
 
-void Sudoku::NewGame() {
+template<int Box>
+void BasicSudoku<Box>::NewGame() {
     // Clear the entire board
-    for(int x = 0; x < 9; x++) {
-        for(int y = 0; y < 9; y++) {
+    for(int x = 0; x < N; x++) {
+        for(int y = 0; y < N; y++) {
             ClearValue(x, y);
         }
     }
 }
 
-int Sudoku::Clean()
+template<int Box>
+int BasicSudoku<Box>::Clean()
 {
-  int x, y, k;
-  for(x=0;x<9;x++)
+  int i;
+  for(i=0;i<CELLS;i++)
   {
-    for(y=0;y<9;y++)
+    if(MaskValue(board.cells[i])==-1)
     {
-      if(GetValue(x, y)==-1)
-      {
-	for(k=0;k<9;k++)
-	{
-	  board[x][y][k]=k;
-	}
-      }
+      WriteCell(i, ALL_CANDIDATES);
     }
   }
+  Propagate();
   return 0;
 }
 
+template<int Box>
+void BasicSudoku<Box>::SetPropagation(bool enabled)
+{
+  propagation = enabled;
+}
 
-int Sudoku::SetValue(int x, int y, int value)
+// Count, for every unit and value, the open cells that still allow the value.
+// Candidates already placed in one of the cell's units are not counted.
+template<int Box>
+void BasicSudoku<Box>::CountPlaces()
 {
-  int i;
-  if(x>=0 && x<=8 && y>=0 && y<=8 && value>=0 && value<=8)
+  const int LANES = (UNITS + 7) / 8 * 8;   // whole registers of 16-bit units
+  const int PLANES = CountBits(N);
+  alignas(16) Mask lanes[N][LANES];
+  alignas(16) Mask planes[PLANES][LANES];
+  Mask open[CELLS];
+
+  for(int cell = 0; cell < CELLS; cell++)
   {
-    for(i=0;i<9;i++)
+    open[cell] = CellCandidates(cell);
+  }
+  for(int i = 0; i < N; i++)
+  {
+    for(int unit = 0; unit < UNITS; unit++)
     {
-      board[x][y][i]=-1;
+      lanes[i][unit] = open[GRID<Box>.unitCells[unit][i]];
+    }
+    for(int unit = UNITS; unit < LANES; unit++)
+    {
+      lanes[i][unit] = 0;
     }
-    board[x][y][value]=value;
-    return 0;
   }
-  else
+
+  CountUnitPlanes(lanes, planes);
+
+  for(int unit = 0; unit < UNITS; unit++)
   {
-    return -1;
+    for(int v = 0; v < N; v++)
+    {
+      int count = 0;
+      for(int k = 0; k < PLANES; k++)
+      {
+        count |= ((planes[k][unit] >> v) & 1) << k;
+      }
+      places[unit][v] = count;
+    }
   }
 }
 
-int Sudoku::GetValue(int x, int y)
+template<int Box>
+void BasicSudoku<Box>::SetSearchFallback(bool enabled)
+{
+  searchFallback = enabled;
+}
+
+// The writes made since the outermost Mark(), each with the cell's mask
+// before it. Inside a mark writes only remove candidates, and a rollback
+// pops what it undoes, so there is at most one entry per candidate.
+template<int Box>
+struct SearchTrail
 {
-  int i,j=9;
-  for(i=0;i<9;i++)
+  static const int CAPACITY = Box * Box * Box * Box * Box * Box;
+  int cells[CAPACITY];
+  typename BasicSudoku<Box>::Mask masks[CAPACITY];
+};
+
+// Every candidate change goes through here so the unit masks stay in step
+template<int Box>
+void BasicSudoku<Box>::WriteCell(int cell, Mask mask)
+{
+  if(trailing && mask != board.cells[cell])
+  {
+    SearchTrail<Box>& journal = trail.Get();
+    journal.cells[trailSize] = cell;
+    journal.masks[trailSize++] = board.cells[cell];
+  }
+  int before = MaskValue(board.cells[cell]);
+  int after = MaskValue(mask);
+  eliminations += BitCount(board.cells[cell] & ~mask);
+  if(after >= 0 && before != after) placements++;
+  board.cells[cell] = mask;
+
+  const auto* units = GRID<Box>.cellUnits[cell];
+  if(before != after)
   {
-    if(board[x][y][i]>=0 && board[x][y][i]<=8)
+    if(before >= 0) board.filled--;
+    if(after >= 0) board.filled++;
+    for(int k = 0; k < 3; k++)
     {
-      if(j==9)
+      int unit = units[k];
+      if(before >= 0)
       {
-	if(board[x][y][i]>=0 && board[x][y][i]<=8)
-	{
-	  j=board[x][y][i];
-	}
+        unsigned char& count = board.counts[unit][before];
+        if(count > 1) board.conflicts--;
+        if(--count == 0) board.used[unit] &= ~(Mask(1) << before);
       }
-      else
+      if(after >= 0)
       {
-	j=-1;
+        unsigned char& count = board.counts[unit][after];
+        if(count > 0) board.conflicts++;
+        count++;
+        board.used[unit] |= Mask(1) << after;
       }
     }
   }
-  if(j==9)
+
+  if(after >= 0)
+  {
+    if(before == after) return;
+    // A new placement: queue it for its peers, or note that they are stale
+    if(propagation && pendingCount < CELLS) pending[pendingCount++] = cell;
+    else board.synced = false;
+  }
+  else if(mask & (board.used[units[0]] | board.used[units[1]] | board.used[units[2]]))
   {
-      j=-1;
+    // An open cell allows a value its peers already hold
+    board.synced = false;
   }
-  return j;
 }
 
-int Sudoku::ClearValue(int x, int y)
+// Remove every queued placement from its peers. Peers that drop to a single
+// candidate are queued in turn, so one call settles all naked singles.
+template<int Box>
+int BasicSudoku<Box>::Propagate()
 {
-  int i;
-  if(x>=0 && x<=8 && y>=0 && y<=8)
+  int eliminated = 0;
+  while(pendingCount > 0)
   {
-    for(i=0;i<9;i++)
+    int cell = pending[--pendingCount];
+    int value = MaskValue(board.cells[cell]);
+    if(value < 0) continue;  // cleared again since it was queued
+
+    Mask bit = Mask(1) << value;
+    for(int peer : GRID<Box>.peers[cell])
     {
-      board[x][y][i]=i;
+      Mask peerMask = board.cells[peer];
+      // Only open cells lose candidates; a clashing placement stays visible
+      if((peerMask & bit) && (peerMask & (peerMask - 1)))
+      {
+        WriteCell(peer, peerMask & ~bit);
+        eliminated++;
+      }
     }
+  }
+  return eliminated;
+}
+
+template<int Box>
+int BasicSudoku<Box>::SetValue(int x, int y, int value)
+{
+  if(x>=0 && x<N && y>=0 && y<N && value>=0 && value<N)
+  {
+    WriteCell(x * N + y, Mask(1) << value);
+    Propagate();
+    return 0;
+  }
+  else
+  {
+    return -1;
+  }
+}
+
+template<int Box>
+int BasicSudoku<Box>::GetValue(int x, int y)
+{
+  return MaskValue(board.cells[x * N + y]);
+}
+
+template<int Box>
+int BasicSudoku<Box>::ClearValue(int x, int y)
+{
+  if(x>=0 && x<N && y>=0 && y<N)
+  {
+    WriteCell(x * N + y, ALL_CANDIDATES);
     return 0;
   }
   else
@@ -180,8 +630,21 @@ int Sudoku::ClearValue(int x, int y)
   }
 }
 
-bool Sudoku::IsValidUnit(std::vector<int>& values) {
-    std::vector<bool> used(9, false);
+template<int Box>
+bool BasicSudoku<Box>::IsCandidate(int x, int y, int value)
+{
+  return (board.cells[x * N + y] >> value) & 1;
+}
+
+template<int Box>
+typename BasicSudoku<Box>::Mask BasicSudoku<Box>::GetCandidates(int x, int y)
+{
+  return board.cells[x * N + y];
+}
+
+template<int Box>
+bool BasicSudoku<Box>::IsValidUnit(std::vector<int>& values) {
+    std::vector<bool> used(N, false);
     // First pass: only look at filled cells
     for(int val : values) {
         if(val != -1) {  // Only check actual filled numbers
@@ -197,11 +660,24 @@ bool Sudoku::IsValidUnit(std::vector<int>& values) {
 
 
 
-bool Sudoku::IsValidSolution() {
+// The board keeps a running count of duplicate placements, so this is O(1)
+template<int Box>
+bool BasicSudoku<Box>::IsValidSolution() {
+#ifdef DEBUG
+    // Debug builds cross-check the counter against a full scan of the grid
+    if(VerifySolution() != (board.conflicts == 0)) {
+        print_debug("Conflict counter out of step with the board (%d)\n", board.conflicts);
+    }
+#endif
+    return board.conflicts == 0;
+}
+
+template<int Box>
+bool BasicSudoku<Box>::VerifySolution() {
     // Check rows
-    for(int row = 0; row < 9; row++) {
+    for(int row = 0; row < N; row++) {
         std::vector<int> values;
-        for(int col = 0; col < 9; col++) {
+        for(int col = 0; col < N; col++) {
             values.push_back(GetValue(row, col));
         }
         if(!IsValidUnit(values)) {
@@ -210,9 +686,9 @@ bool Sudoku::IsValidSolution() {
     }
     
     // Check columns
-    for(int col = 0; col < 9; col++) {
+    for(int col = 0; col < N; col++) {
         std::vector<int> values;
-        for(int row = 0; row < 9; row++) {
+        for(int row = 0; row < N; row++) {
             values.push_back(GetValue(row, col));
         }
         if(!IsValidUnit(values)) {
@@ -220,14 +696,14 @@ bool Sudoku::IsValidSolution() {
         }
     }
     
-    // Check 3x3 boxes
-    for(int box = 0; box < 9; box++) {
+    // Check boxes
+    for(int box = 0; box < N; box++) {
         std::vector<int> values;
-        int startRow = (box / 3) * 3;
-        int startCol = (box % 3) * 3;
+        int startRow = (box / Box) * Box;
+        int startCol = (box % Box) * Box;
         
-        for(int i = 0; i < 3; i++) {
-            for(int j = 0; j < 3; j++) {
+        for(int i = 0; i < Box; i++) {
+            for(int j = 0; j < Box; j++) {
                 values.push_back(GetValue(startRow + i, startCol + j));
             }
         }
@@ -239,17 +715,6 @@ bool Sudoku::IsValidSolution() {
     return true;
 }
 
-void Sudoku::RestoreBoard(int original_board[9][9][9], int board[9][9][9]) {
-    int i, j, k; 
-    for (i = 0; i < 9; i++) { 
-        for (j = 0; j < 9; j++) {
-            for (k = 0; k < 9; k++) { 
-                original_board[i][j][k] = board[i][j][k];
-            } 
-        } 
-   }
-} 
-
 /*#ifdef MSDOS
 
 #define DEBUG_BUFFER_SIZE 10
@@ -276,7 +741,8 @@ void Sudoku::print_debug(const char *format, ...) {
 }
 #endif */
 
-void Sudoku::ExportToExcelXML(const string& filename) {
+template<int Box>
+void BasicSudoku<Box>::ExportToExcelXML(const string& filename) {
     ofstream file(filename);
     if (!file.is_open()) {
         cerr << "Error: Could not create file " << filename << endl;
@@ -329,13 +795,13 @@ void Sudoku::ExportToExcelXML(const string& filename) {
     
     // Set column widths
     file << " <Table ss:StyleID=\"Default\">\n";
-    for(int i = 0; i < 9; i++) {
+    for(int i = 0; i < N; i++) {
         file << "  <Column ss:Width=\"40\"/>\n";
     }
 
     // Header row
     file << "  <Row ss:Height=\"30\">\n";
-    file << "   <Cell ss:MergeAcross=\"8\" ss:StyleID=\"Header\">";
+    file << "   <Cell ss:MergeAcross=\"" << N - 1 << "\" ss:StyleID=\"Header\">";
     file << "    <Data ss:Type=\"String\">Created with Sudoku Solver</Data>";
     file << "   </Cell>\n";
     file << "  </Row>\n";
@@ -344,16 +810,16 @@ void Sudoku::ExportToExcelXML(const string& filename) {
     file << "  <Row ss:Height=\"20\"/>\n";
 
     // Puzzle data
-    for(int row = 0; row < 9; row++) {
+    for(int row = 0; row < N; row++) {
         file << "  <Row ss:Height=\"40\">\n";
-        for(int col = 0; col < 9; col++) {
-            string styleID = ((row/3)*3 <= row && row < (row/3)*3 + 3 && 
-                            (col/3)*3 <= col && col < (col/3)*3 + 3) 
+        for(int col = 0; col < N; col++) {
+            string styleID = ((row/Box)*Box <= row && row < (row/Box)*Box + Box && 
+                            (col/Box)*Box <= col && col < (col/Box)*Box + Box) 
                            ? "BoxBorder" : "Default";
             
             file << "   <Cell ss:StyleID=\"" << styleID << "\">";
             int val = GetValue(col, row);
-            if(val >= 0 && val <= 8) {
+            if(val >= 0 && val < N) {
                 file << "<Data ss:Type=\"Number\">" << (val + 1) << "</Data>";
             } else {
                 file << "<Data ss:Type=\"String\"></Data>";
@@ -370,7 +836,8 @@ void Sudoku::ExportToExcelXML(const string& filename) {
     file.close();
 }
 
-    void Sudoku::LogBoard(std::ofstream& file, const char* algorithm_name) {
+template<int Box>
+void BasicSudoku<Box>::LogBoard(std::ofstream& file, const char* algorithm_name) {
         file << "\n=== " << algorithm_name << " ===\n";
         
         // Print timestamp
@@ -378,253 +845,396 @@ void Sudoku::ExportToExcelXML(const string& filename) {
         file << "Time: " << ctime(&now);
         
         // Print horizontal border
-        file << "+---+---+---+---+---+---+---+---+---+\n";
+        string border = "+";
+        for(int i = 0; i < N; i++) border += "---+";
+        file << border << "\n";
         
         // Print board contents
-        for(int y = 0; y < 9; y++) {
+        for(int y = 0; y < N; y++) {
             file << "|";
-            for(int x = 0; x < 9; x++) {
+            for(int x = 0; x < N; x++) {
                 int value = GetValue(x, y);
-                if(value >= 0 && value <= 8) {
-                    file << " " << value + 1 << " ";
+                if(value >= 0 && value < N) {
+                    file << " " << ValueChar(value) << " ";
                 } else {
                     file << " . ";
                 }
-                if((x + 1) % 3 == 0) file << "|";
+                if((x + 1) % Box == 0) file << "|";
                 else file << " ";
             }
             file << "\n";
             
             // Print horizontal borders
-            if((y + 1) % 3 == 0) {
-                file << "+---+---+---+---+---+---+---+---+---+\n";
+            if((y + 1) % Box == 0) {
+                file << border << "\n";
             }
         }
         file << "\n";
   int x, y, k;
-  for(x=0;x<9;x++)
+  for(x=0;x<N;x++)
   {
-    for(y=0;y<9;y++)
+    for(y=0;y<N;y++)
     {
       file << "|";
-      for(k=0;k<9;k++)
+      for(k=0;k<N;k++)
       {
-        file << board[y][x][k]+1;
+        file << (IsCandidate(y, x, k) ? ValueChar(k) : '0');
       }
     }
     file  << "|\n";
   }
 }
 
-int Sudoku::Solve() {
-    bool changes_made;
-    int result;
-    
-    do {
-        changes_made = false;
-        
-        // First phase: Alternate between Standard and Line elimination until no changes
-        bool basic_changes;
-        do {
-            basic_changes = false;
-            
-            // Run Standard elimination
-            print_debug("Running StdElim...\n");
-            result = StdElim();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after StdElim\n");
-                return -1;
-            }
-            if (result > 0) {
-                basic_changes = true;
-                changes_made = true;
-            }
-            
-            // Run Line elimination
-            print_debug("Running LinElim...\n");
-            result = LinElim();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after LinElim\n");
-                return -1;
-            }
-            if (result > 0) {
-                basic_changes = true;
-                changes_made = true;
-            }
-            
-        } while (basic_changes);
-        
-        // If no basic changes, try advanced techniques in sequence
-        if (!changes_made) {
-            // Try Hidden Singles
-            print_debug("Running FindHiddenSingles...\n");
-            result = FindHiddenSingles();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindHiddenSingles\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
-            
-            // Try Hidden Pairs
-            print_debug("Running FindHiddenPairs...\n");
-            result = FindHiddenPairs();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindHiddenPairs\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
-            
-            // Try Pointing Pairs
-            print_debug("Running FindPointingPairs...\n");
-            result = FindPointingPairs();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindPointingPairs\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
-            
-            // Try X-Wing
-            print_debug("Running FindXWing...\n");
-            result = FindXWing();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindXWing\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
-            
-            // Try Swordfish
-            print_debug("Running FindSwordFish...\n");
-            result = FindSwordFish();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindSwordFish\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
-            
-            // Try Naked Sets
-            print_debug("Running FindNakedSets...\n");
-            result = FindNakedSets();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindNakedSets\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
+static const char* const TECHNIQUE_NAMES[TECH_COUNT] = {
+    "Standard Elimination", "Line Elimination", "Hidden Singles", "Hidden Pairs",
+    "Pointing Pairs", "X-Wing", "Swordfish", "Jellyfish", "Naked Sets", "Hidden Sets",
+    "XY-Wing", "XYZ-Wing", "Finned Fish", "Simple Coloring", "Alternating Chains",
+    "ALS-XZ", "ALS-XY-Wing", "Nishio"
+};
+
+// Approximate Sudoku Explainer ratings. Naked sets take the pair rating
+// (triples are 3.6 and quads 5.0), hidden sets the triple rating (quads are
+// 5.4), finned fish that of a finned Swordfish, simple coloring that of an
+// X-chain and alternating chains that of a forcing chain. Sudoku Explainer
+// has no ALS rules; they are placed above the chains they shorten. Nishio
+// takes the rating of a Nishio forcing chain.
+static const double TECHNIQUE_DIFFICULTY[TECH_COUNT] = {
+    2.3, 2.6, 1.5, 3.4, 2.6, 3.2, 3.8, 5.2, 3.0, 4.0, 4.2, 4.4, 4.0, 6.6, 7.0, 7.5, 8.0, 8.5
+};
+
+// Registry of the technique passes, indexed by SolveTechnique
+template<int Box>
+static int (BasicSudoku<Box>::* const TECHNIQUES[TECH_COUNT])() = {
+    &BasicSudoku<Box>::StdElim, &BasicSudoku<Box>::LinElim,
+    &BasicSudoku<Box>::FindHiddenSingles, &BasicSudoku<Box>::FindHiddenPairs,
+    &BasicSudoku<Box>::FindPointingPairs, &BasicSudoku<Box>::FindXWing,
+    &BasicSudoku<Box>::FindSwordFish, &BasicSudoku<Box>::FindJellyfish,
+    &BasicSudoku<Box>::FindNakedSets, &BasicSudoku<Box>::FindHiddenSets,
+    &BasicSudoku<Box>::FindXYWing, &BasicSudoku<Box>::FindXYZWing,
+    &BasicSudoku<Box>::FindFinnedFish, &BasicSudoku<Box>::FindSimpleColoring,
+    &BasicSudoku<Box>::FindChains, &BasicSudoku<Box>::FindAlsXZ,
+    &BasicSudoku<Box>::FindAlsXYWing, &BasicSudoku<Box>::FindNishio
+};
+
+SolvePipeline::SolvePipeline()
+    : count(0), restart(RESTART_CHEAPEST), adaptive(false)
+{
+    ResetStatistics();
+    for (int technique = 0; technique < TECH_COUNT; technique++) {
+        order[count++] = static_cast<SolveTechnique>(technique);
+    }
+}
 
-            // Try Find XY Wing
-            print_debug("Running Find XY Wing...\n");
-            result = FindXYWing();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindXYWing\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
+SolvePipeline::SolvePipeline(std::initializer_list<SolveTechnique> techniques, RestartPolicy policy)
+    : count(0), restart(policy), adaptive(false)
+{
+    ResetStatistics();
+    for (SolveTechnique technique : techniques) {
+        Add(technique);
+    }
+}
 
-            // Try Find XYZ Wing
-            print_debug("Running Find XYZ Wing...\n");
-            result = FindXYZWing();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindXYZWing\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }
+void SolvePipeline::Clear()
+{
+    count = 0;
+}
 
-            /*print_debug("Running FindSimpleColoring...\n");
-            result = FindSimpleColoring();
-            if (!IsValidSolution()) {
-                print_debug("Invalid solution detected after FindSimpleColoring\n");
-                return -1;
-            }
-            if (result > 0) {
-                changes_made = true;
-                continue;  // Start over with basic eliminations
-            }*/
+void SolvePipeline::Add(SolveTechnique technique)
+{
+    if (technique < 0 || technique >= TECH_COUNT) return;
+    Remove(technique);
+    order[count++] = technique;
+}
+
+void SolvePipeline::Remove(SolveTechnique technique)
+{
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (order[i] != technique) order[kept++] = order[i];
+    }
+    count = kept;
+}
+
+bool SolvePipeline::Contains(SolveTechnique technique) const
+{
+    for (int i = 0; i < count; i++) {
+        if (order[i] == technique) return true;
+    }
+    return false;
+}
+
+void SolvePipeline::ResetStatistics()
+{
+    for (int technique = 0; technique < TECH_COUNT; technique++) {
+        calls[technique] = 0;
+        hits[technique] = 0;
+        nanoseconds[technique] = 0;
+    }
+}
 
+void SolvePipeline::Record(SolveTechnique technique, bool progress, long long elapsed)
+{
+    if (technique < 0 || technique >= TECH_COUNT) return;
+    calls[technique]++;
+    if (progress) hits[technique]++;
+    nanoseconds[technique] += elapsed;
+}
 
+void SolvePipeline::Schedule(SolveTechnique (&run)[TECH_COUNT]) const
+{
+    // Score each technique by successful calls per nanosecond spent. The
+    // extra hit and microsecond give untried techniques a fair first score.
+    double score[TECH_COUNT];
+    for (int i = 0; i < count; i++) {
+        run[i] = order[i];
+        score[i] = adaptive ? (hits[order[i]] + 1.0) / (nanoseconds[order[i]] + 1000.0) : 0;
+    }
+    if (!adaptive) return;
+
+    // Insertion sort, best first; equal scores keep the pipeline order
+    for (int i = 1; i < count; i++) {
+        SolveTechnique technique = run[i];
+        double value = score[i];
+        int j = i;
+        for (; j > 0 && score[j - 1] < value; j--) {
+            run[j] = run[j - 1];
+            score[j] = score[j - 1];
         }
-        
-    } while (changes_made);
-    
-    // Final validation check
-    if (!IsValidSolution()) {
-        print_debug("Invalid final solution detected\n");
-        return -1;
+        run[j] = technique;
+        score[j] = value;
     }
-    
-    return 0;
 }
-int Sudoku::SolveBasic() {
-    int counter1, counter2, i, j;
-    #ifdef _NCURSES
-    move(22, 0);
-    printw("Starting Solve() - Cleaning board...\n");
-    #endif
-    //Clean();
-    int original_board[9][9][9];
+
+const char* SolvePipeline::Name(SolveTechnique technique)
+{
+    return (technique >= 0 && technique < TECH_COUNT) ? TECHNIQUE_NAMES[technique] : "Unknown";
+}
+
+double SolvePipeline::Difficulty(SolveTechnique technique)
+{
+    return (technique >= 0 && technique < TECH_COUNT) ? TECHNIQUE_DIFFICULTY[technique] : 0;
+}
+
+template<int Box>
+int BasicSudoku<Box>::Solve() {
+    // Most puzzles need nothing but singles; the pipeline picks up the rest
+    if(SolveSingles()) return 0;
+    SolvePipeline pipeline;
+    return Solve(pipeline);
+}
+
+template<int Box>
+int BasicSudoku<Box>::Solve(SolvePipeline& pipeline) {
+    bool previous = propagation;
+    SetPropagation(true);
+    int result = RunSolve(pipeline);
+    if (result == 0 && searchFallback && !IsSolved()) {
+        result = RunSearch();
+    }
+    SetPropagation(previous);
+    return result;
+}
+
+template<int Box>
+int BasicSudoku<Box>::RunTechnique(SolveTechnique technique) {
+    if (technique < 0 || technique >= TECH_COUNT) return -1;
+    long long eliminated = eliminations, placed = placements;
+    auto start = std::chrono::steady_clock::now();
+    int result = (this->*TECHNIQUES<Box>[technique])();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    TechniqueStats& entry = stats[technique];
+    entry.calls++;
+    if (result > 0) entry.successes++;
+    entry.eliminated += eliminations - eliminated;
+    entry.placed += placements - placed;
+    entry.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return result;
+}
+
+template<int Box>
+void BasicSudoku<Box>::ResetTechniqueStats() {
+    for (int technique = 0; technique < TECH_COUNT; technique++) {
+        stats[technique] = TechniqueStats();
+    }
+}
+
+template<int Box>
+int BasicSudoku<Box>::RunSolve(SolvePipeline& pipeline) {
+    int size = pipeline.Size();
+    bool adaptive = pipeline.IsAdaptive();
+    SolveTechnique run[TECH_COUNT];
+    pipeline.Schedule(run);
+
+    // Stop once every technique has come up empty since the last change,
+    // whatever order they ran in
+    unsigned int listed = 0, idle = 0;
+    for (int i = 0; i < size; i++) {
+        listed |= 1u << run[i];
+    }
+
+    int index = 0;
+    while (idle != listed) {
+        SolveTechnique technique = run[index];
+        long long spent = stats[technique].nanoseconds;
+        int result = RunTechnique(technique);
+        if (adaptive) {
+            pipeline.Record(technique, result > 0, stats[technique].nanoseconds - spent);
+        }
+        Trace(TRACE_PASS, technique, -1, result);
+
+        if (!IsValidSolution()) {
+            print_debug("Invalid solution detected after %s\n", SolvePipeline::Name(technique));
+            return -1;
+        }
+
+        if (result > 0) {
+            idle = 0;
+            if (pipeline.GetRestartPolicy() == SolvePipeline::RESTART_CHEAPEST) {
+                // Start over with the cheapest technique
+                if (adaptive) pipeline.Schedule(run);
+                index = 0;
+                continue;
+            }
+        } else {
+            idle |= 1u << technique;
+        }
+
+        if (++index == size) {
+            if (adaptive) pipeline.Schedule(run);
+            index = 0;
+        }
+    }
     
+    // Final validation check
+    if (!IsValidSolution()) {
+        print_debug("Invalid final solution detected\n");
+        return -1;
+    }
+    
+    return 0;
+}
+
+// Solve with the easiest technique that makes progress, going back to the
+// easiest after every step, and undo it all through the journal. Naked
+// singles fall out of propagation and are rated with the hidden singles.
+// When the techniques stall, hardest stays the hardest that made progress.
+// The profile is put back too, as rating is not solving and the generator
+// rates every attempt.
+template<int Box>
+Rating BasicSudoku<Box>::Rate() {
+    static const SolveTechnique easiestFirst[] = {
+        TECH_HIDDEN_SINGLES, TECH_LINE_ELIM, TECH_POINTING_PAIRS, TECH_NAKED_SETS,
+        TECH_X_WING, TECH_HIDDEN_PAIRS, TECH_SWORDFISH, TECH_HIDDEN_SETS, TECH_FINNED_FISH,
+        TECH_XY_WING, TECH_XYZ_WING, TECH_JELLYFISH, TECH_SIMPLE_COLORING, TECH_CHAINS,
+        TECH_ALS_XZ, TECH_ALS_XY_WING, TECH_NISHIO
+    };
+    const int count = sizeof(easiestFirst) / sizeof(easiestFirst[0]);
+
+    Rating rating = Rating();
+    rating.hardest = TECH_COUNT;
+
+    bool previous = propagation;
+    bool synced = board.synced;
+    TechniqueStats profile[TECH_COUNT];
+    std::copy(stats, stats + TECH_COUNT, profile);
+    long long eliminated = eliminations, placed = placements;
+    size_t mark = Mark();
+    SetPropagation(true);
+    int filled = board.filled;
+    StdElim();
+
+    int index = 0;
+    while (index < count) {
+        SolveTechnique technique = easiestFirst[index];
+        bool progress;
+        if (technique == TECH_HIDDEN_SINGLES) {
+            // The search's singles sweep finds the same placements without
+            // recounting the units after each one
+            if (!SearchSingles()) break;
+            progress = board.filled > filled;
+        } else {
+            progress = RunTechnique(technique) > 0;
+        }
+        filled = board.filled;
+        if (!IsValidSolution()) break;
+        if (!progress) {
+            index++;
+            continue;
+        }
+        rating.steps[technique]++;
+        if (SolvePipeline::Difficulty(technique) > rating.score) {
+            rating.score = SolvePipeline::Difficulty(technique);
+            rating.hardest = technique;
+        }
+        if (IsSolved()) break;
+        index = 0;
+    }
+    rating.solved = IsSolved();
+    if (!rating.solved) rating.score = UNSOLVED_SCORE;
+
+    SetPropagation(previous);
+    Rollback(mark);
+    Commit();
+    board.synced = synced;
+    std::copy(profile, profile + TECH_COUNT, stats);
+    eliminations = eliminated;
+    placements = placed;
+    return rating;
+}
+
+template<int Box>
+int BasicSudoku<Box>::SolveBasic() {
+    bool previous = propagation;
+    SetPropagation(true);
+    int result = RunSolveBasic();
+    SetPropagation(previous);
+    return result;
+}
+
+template<int Box>
+int BasicSudoku<Box>::RunSolveBasic() {
+    int counter1, counter2, i, j;
+    #ifdef _NCURSES
+    move(22, 0);
+    printw("Starting Solve() - Cleaning board...\n");
+    #endif
+    //Clean();
     
     do {
-        RestoreBoard(original_board, board);
         counter1 = 0;
         counter2 = 0;
-        for(i = 0; i < 9; i++) {
-            for(j = 0; j < 9; j++) {
+        for(i = 0; i < N; i++) {
+            for(j = 0; j < N; j++) {
                 if(GetValue(i,j) != -1) {
                     counter1++;
                 }
             }
         }
         
-        if(counter1 != 81) {
+        if(counter1 != CELLS) {
             // Run each solving technique and validate after each
-            print_debug("Running StdElim...                    \n");
-            StdElim();
+            Trace(TRACE_PASS, TECH_STD_ELIM, -1, RunTechnique(TECH_STD_ELIM));
             if(!IsValidSolution()) {
                 print_debug("Invalid solution detected after StdElim\n");
-                //RestoreBoard(board, original_board);
                 return -1;
             }
             
-            print_debug("Running LinElim...                    \n");
-            LinElim();
+            Trace(TRACE_PASS, TECH_LINE_ELIM, -1, RunTechnique(TECH_LINE_ELIM));
             if(!IsValidSolution()) {
                 print_debug("Invalid solution detected after LinElim\n");
-                //RestoreBoard(board, original_board);
                 return -1;
             }
             
-            for(i = 0; i < 9; i++) {
-                for(j = 0; j < 9; j++) {
+            for(i = 0; i < N; i++) {
+                for(j = 0; j < N; j++) {
                     if(GetValue(i,j) != -1) {
                         counter2++;
                     }
                 }
             }
         } else {
-            counter2 = 81;
+            counter2 = CELLS;
         }
     } while(counter1 != counter2);
     
@@ -639,315 +1249,633 @@ int Sudoku::SolveBasic() {
 
 
 
-int Sudoku::EliminatePossibility(int x, int y, int value)
+// Dancing Links exact-cover search over the 4 * CELLS Sudoku constraints:
+// one value per cell and each value once per row, column and box. Option
+// cell * N + value covers one column of each kind.
+template<int Box>
+class DancingLinks {
+public:
+    DancingLinks();
+    void Place(int cell, int value);    // fix a given before searching
+    int Count(int limit);               // solutions found, stopping at limit
+    int solution[Box * Box * Box * Box];    // values of the first solution found
+
+private:
+    enum { N = Box * Box, CELLS = N * N, COLUMNS = 4 * CELLS, OPTIONS = CELLS * N,
+           NODES = 1 + COLUMNS + OPTIONS * 4 };
+    int left[NODES], right[NODES], up[NODES], down[NODES];
+    int column[NODES], option[NODES];
+    int size[COLUMNS + 1];
+    int firstNode[OPTIONS];
+    int chosen[CELLS];
+    int depth, found, limit;
+
+    void Cover(int c);
+    void Uncover(int c);
+    void Search();
+};
+
+template<int Box>
+DancingLinks<Box>::DancingLinks() : depth(0), found(0), limit(1) {
+    // Node 0 is the root, 1..COLUMNS the column headers
+    for(int c = 0; c <= COLUMNS; c++) {
+        left[c] = c - 1;
+        right[c] = c + 1;
+        up[c] = down[c] = column[c] = c;
+        size[c] = 0;
+    }
+    left[0] = COLUMNS;
+    right[COLUMNS] = 0;
+
+    int node = COLUMNS + 1;
+    for(int cell = 0; cell < CELLS; cell++) {
+        int x = cell / N, y = cell % N;
+        solution[cell] = -1;
+        for(int value = 0; value < N; value++) {
+            int o = cell * N + value;
+            int columns[4] = {1 + cell,
+                              1 + CELLS + x * N + value,
+                              1 + 2 * CELLS + y * N + value,
+                              1 + 3 * CELLS + (GRID<Box>.cellUnits[cell][2] - 2 * N) * N + value};
+            firstNode[o] = node;
+            for(int k = 0; k < 4; k++, node++) {
+                int c = columns[k];
+                column[node] = c;
+                option[node] = o;
+                left[node] = k == 0 ? node + 3 : node - 1;
+                right[node] = k == 3 ? node - 3 : node + 1;
+                up[node] = up[c];
+                down[node] = c;
+                down[up[c]] = node;
+                up[c] = node;
+                size[c]++;
+            }
+        }
+    }
+}
+
+template<int Box>
+void DancingLinks<Box>::Cover(int c) {
+    right[left[c]] = right[c];
+    left[right[c]] = left[c];
+    for(int i = down[c]; i != c; i = down[i]) {
+        for(int j = right[i]; j != i; j = right[j]) {
+            down[up[j]] = down[j];
+            up[down[j]] = up[j];
+            size[column[j]]--;
+        }
+    }
+}
+
+template<int Box>
+void DancingLinks<Box>::Uncover(int c) {
+    for(int i = up[c]; i != c; i = up[i]) {
+        for(int j = left[i]; j != i; j = left[j]) {
+            size[column[j]]++;
+            down[up[j]] = j;
+            up[down[j]] = j;
+        }
+    }
+    right[left[c]] = c;
+    left[right[c]] = c;
+}
+
+template<int Box>
+void DancingLinks<Box>::Place(int cell, int value) {
+    int r = firstNode[cell * N + value];
+    Cover(column[r]);
+    for(int j = right[r]; j != r; j = right[j]) {
+        Cover(column[j]);
+    }
+    solution[cell] = value;
+}
+
+template<int Box>
+int DancingLinks<Box>::Count(int max) {
+    limit = max;
+    found = 0;
+    depth = 0;
+    Search();
+    return found;
+}
+
+template<int Box>
+void DancingLinks<Box>::Search() {
+    if(right[0] == 0) {
+        if(found == 0) {
+            for(int i = 0; i < depth; i++) {
+                solution[chosen[i] / N] = chosen[i] % N;
+            }
+        }
+        found++;
+        return;
+    }
+
+    // Branch on the column with the fewest remaining options
+    int best = right[0];
+    for(int c = right[best]; c != 0; c = right[c]) {
+        if(size[c] < size[best]) best = c;
+    }
+    if(size[best] == 0) return;
+
+    Cover(best);
+    for(int r = down[best]; r != best && found < limit; r = down[r]) {
+        chosen[depth++] = option[r];
+        for(int j = right[r]; j != r; j = right[j]) Cover(column[j]);
+        Search();
+        for(int j = left[r]; j != r; j = left[j]) Uncover(column[j]);
+        depth--;
+    }
+    Uncover(best);
+}
+
+template<int Box>
+int BasicSudoku<Box>::ExactCover(int limit, bool fill)
 {
-  if(x>=0 && x<=8 && y>=0 && y<=8 && value>=0 && value<=8)
+  // Duplicate givens would cover a constraint twice
+  if(board.conflicts > 0 || limit < 1) return 0;
+
+  std::unique_ptr<DancingLinks<Box>> links(new DancingLinks<Box>());
+  for(int cell = 0; cell < CELLS; cell++)
   {
-    board[x][y][value]=-1;
-    return 0;
+    int value = MaskValue(board.cells[cell]);
+    if(value >= 0) links->Place(cell, value);
   }
-  else
+
+  int found = links->Count(limit);
+  if(found > 0 && fill)
   {
-    return -1;
+    for(int cell = 0; cell < CELLS; cell++)
+    {
+      if(MaskValue(board.cells[cell]) < 0)
+      {
+        WriteCell(cell, Mask(1) << links->solution[cell]);
+      }
+    }
+    Propagate();
   }
+  return found;
 }
 
-bool Sudoku::LegalValue(int x, int y, int value)
+// Depth-first search over the cells the techniques left open. Every write
+// made below the entry point is recorded in the trail, so a failed branch is
+// undone by replaying it backwards rather than by copying the board.
+template<int Box>
+int BasicSudoku<Box>::RunSearch()
 {
-    int i, j, temp, section1, section2;
-  if(x>=0 && x<=8 && y>=0 && y<=8)
+  print_debug("Running backtracking search...\n");
+  StdElim();
+  bool synced = board.synced;
+  size_t start = Mark();
+  bool solved = Search();
+  if(!solved)
   {
-      for(i=0;i<x;i++)
+    print_debug("Backtracking search found no solution\n");
+    Rollback(start);
+    board.synced = synced;
+  }
+  Commit();
+  if(!solved) return -1;
+  return IsValidSolution() ? 0 : -1;
+}
+
+template<int Box>
+bool BasicSudoku<Box>::Search()
+{
+  if(!SearchSingles()) return false;
+
+  // Branch on the open cell with the fewest candidates
+  int best = -1, bestCount = N + 1;
+  for(int cell = 0; cell < CELLS && bestCount > 2; cell++)
+  {
+    int count = BitCount(board.cells[cell]);
+    if(count == 0) return false;
+    if(count > 1 && count < bestCount)
+    {
+      best = cell;
+      bestCount = count;
+    }
+  }
+  if(best < 0) return true;
+
+  Mask options = board.cells[best];
+  size_t mark = Mark();
+  bool solved = false;
+  while(options && !solved)
+  {
+    int value = LowestBit(options);
+    options &= options - 1;
+    WriteCell(best, Mask(1) << value);
+    solved = Search();
+    if(!solved) Rollback(mark);
+  }
+  Commit();
+  return solved;
+}
+
+// Place naked and hidden singles until none are left, or for at most rounds
+// sweeps of the units. Returns false if the board can no longer be completed.
+template<int Box>
+bool BasicSudoku<Box>::SearchSingles(int rounds)
+{
+  bool placed;
+  do
+  {
+    Propagate();
+    if(board.conflicts > 0) return false;
+
+    placed = false;
+    for(int unit = 0; unit < UNITS; unit++)
+    {
+      Mask once = 0, twice = 0;
+      for(int i = 0; i < N; i++)
       {
-	temp=GetValue(i, y);
-	if(temp==value)
-	{
-	  return false;
-	}
+        Mask mask = board.cells[GRID<Box>.unitCells[unit][i]];
+        if(mask == 0) return false;
+        if(mask & (mask - 1))
+        {
+          twice |= once & mask;
+          once |= mask;
+        }
       }
-      for(i=x+1;i<9;i++)
+      if((once | board.used[unit]) != ALL_CANDIDATES) return false;
+
+      Mask hidden = once & ~twice & ~board.used[unit];
+      for(int i = 0; i < N && hidden; i++)
       {
-	temp=GetValue(i, y);
-	if(temp==value)
-	{
-	  return false;
-	}
+        int cell = GRID<Box>.unitCells[unit][i];
+        Mask mask = board.cells[cell];
+        if((mask & hidden) && (mask & (mask - 1)))
+        {
+          Mask bit = Mask(1) << LowestBit(mask & hidden);
+          WriteCell(cell, bit);
+          hidden &= ~bit;
+          placed = true;
+        }
       }
-      for(i=0;i<y;i++)
+    }
+  } while(placed && --rounds > 0);
+  return true;
+}
+
+// Trace reason of a hidden single, by the kind of unit it was found in
+static const char* const HIDDEN_SINGLE_REASONS[3] = {
+    "only place in its row", "only place in its column", "only place in its box"
+};
+
+// The kernel stands in for standard elimination and hidden singles, so its
+// work is booked to them: the naked singles, the candidates removed and the
+// time to the first, the hidden singles to the second.
+template<int Box>
+bool BasicSudoku<Box>::SolveSingles()
+{
+  int placed[2] = {0, 0};     // naked, hidden
+  long long eliminated = eliminations;
+  auto start = std::chrono::steady_clock::now();
+  bool full = RunSolveSingles(placed);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  TechniqueStats& naked = stats[TECH_STD_ELIM];
+  naked.calls++;
+  if(placed[0] > 0) naked.successes++;
+  naked.eliminated += eliminations - eliminated;
+  naked.placed += placed[0];
+  naked.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  TechniqueStats& hidden = stats[TECH_HIDDEN_SINGLES];
+  hidden.calls++;
+  if(placed[1] > 0) hidden.successes++;
+  hidden.placed += placed[1];
+  return full;
+}
+
+// Singles-only kernel over one cell set per value: where[v] holds the cells
+// that can still take v, read through the open set so placed cells need not
+// be cleared from it. A placement is a few word operations and the naked
+// singles fall out of a once/twice pass over the sets. Works on local state,
+// so the counters, journal and queue are only touched when the result is
+// written back. Tracing the placements would cost more than making them, so
+// only level 2 does. placed gets the naked and hidden singles written back.
+template<int Box>
+bool BasicSudoku<Box>::RunSolveSingles(int (&placed)[2])
+{
+  typedef CellSet<CELLS> Cells;
+  const int WORDS = Cells::WORDS;
+  Mask cells[CELLS];      // placed values, the open cells are rebuilt at the end
+  Mask missing[UNITS];    // values no cell of the unit holds yet
+  Cells where[N] = {};
+  int found[2] = {0, 0};
+  Cells open = {}, given = {};
+  int filled = 0;
+  for(int unit = 0; unit < UNITS; unit++) missing[unit] = ALL_CANDIDATES;
+  // Spread the open masks over the value sets, the given values are then
+  // placed like any other
+  for(int cell = 0; cell < CELLS; cell++)
+  {
+    Mask mask = board.cells[cell];
+    if(!mask) return false;
+    cells[cell] = mask;
+    if(!(mask & (mask - 1)))
+    {
+      given.Add(cell);
+      continue;
+    }
+    open.Add(cell);
+    for(; mask; mask &= mask - 1) where[LowestBit(mask)].Add(cell);
+  }
+
+  // Place v, false when a unit of the cell already holds it
+  auto place = [&](int cell, int v) {
+    Mask bit = Mask(1) << v;
+    const auto* units = GRID<Box>.cellUnits[cell];
+    if(!(missing[units[0]] & missing[units[1]] & missing[units[2]] & bit)) return false;
+    missing[units[0]] &= ~bit;
+    missing[units[1]] &= ~bit;
+    missing[units[2]] &= ~bit;
+    cells[cell] = bit;
+    filled++;
+    open.words[cell >> 6] &= ~(1ULL << (cell & 63));
+    for(int w = 0; w < WORDS; w++) where[v].words[w] &= ~GRID<Box>.sees[cell].words[w];
+    return true;
+  };
+  for(int w = 0; w < WORDS; w++)
+  {
+    for(unsigned long long left = given.words[w]; left; left &= left - 1)
+    {
+      int cell = w * 64 + LowestBit(left);
+      if(!place(cell, LowestBit(cells[cell]))) return false;
+    }
+  }
+
+  bool progress = true;
+  while(progress && filled < CELLS)
+  {
+    // Naked singles: open cells in exactly one value's set. Settle them
+    // before the dearer unit pass.
+    progress = false;
+    Cells once = {}, twice = {};
+    for(int v = 0; v < N; v++)
+    {
+      for(int w = 0; w < WORDS; w++)
       {
-	temp=GetValue(x, i);
-	if(temp==value)
-	{
-	  return false;
-	}
+        twice.words[w] |= once.words[w] & where[v].words[w];
+        once.words[w] |= where[v].words[w];
       }
-      for(i=y+1;i<9;i++)
+    }
+    for(int w = 0; w < WORDS; w++)
+    {
+      if(open.words[w] & ~once.words[w]) return false;    // no value left
+    }
+    for(int v = 0; v < N; v++)
+    {
+      for(int w = 0; w < WORDS; w++)
       {
-	temp=GetValue(x, i);
-	if(temp==value)
-	{
-	  return false;
-	}
+        unsigned long long singles = where[v].words[w] & open.words[w] & ~twice.words[w];
+        for(; singles; singles &= singles - 1)
+        {
+          int cell = w * 64 + LowestBit(singles);
+          if(!place(cell, v)) return false;     // a peer took v in this pass
+          if(SUDOKU_TRACE_LEVEL >= 2) Trace(TRACE_PLACE, TECH_STD_ELIM, cell, v, "last candidate left");
+          found[0]++;
+          progress = true;
+        }
       }
-      section1=(x/3)*3;
-      section2=(y/3)*3;
-      for(i=0;i<3;i++)
+    }
+    if(progress) continue;
+
+    // Hidden singles: a value the unit is missing with one place left
+    for(int unit = 0; unit < UNITS; unit++)
+    {
+      const Cells& members = GRID<Box>.unitSets[unit];
+      for(Mask values = missing[unit]; values; values &= values - 1)
       {
-	for(j=0;j<3;j++)
-	{
-	  if(x!=(section1+j) || y!=(section2+i))
-	  {
-	    temp=GetValue(section1+j, section2+i);
-	    if(temp==value)
-	    {
-	      return false;
-	    }
-	  }
-	}
+        int v = LowestBit(values);
+        int count = 0, cell = -1;
+        for(int w = 0; w < WORDS; w++)
+        {
+          unsigned long long takes = where[v].words[w] & members.words[w] & open.words[w];
+          if(!takes) continue;
+          count += (takes & (takes - 1)) ? 2 : 1;
+          cell = w * 64 + LowestBit(takes);
+        }
+        if(count == 0) return false;
+        if(count > 1) continue;
+        if(!place(cell, v)) return false;
+        if(SUDOKU_TRACE_LEVEL >= 2) Trace(TRACE_PLACE, TECH_HIDDEN_SINGLES, cell, v, HIDDEN_SINGLE_REASONS[unit / N]);
+        found[1]++;
+        progress = true;
       }
-    return true;
+    }
   }
-  else
+
+  // Rebuild the open cells from the sets and write back what changed
+  for(int w = 0; w < WORDS; w++)
   {
-    return false;
+    for(unsigned long long left = open.words[w]; left; left &= left - 1)
+    {
+      int cell = w * 64 + LowestBit(left);
+      Mask mask = 0;
+      for(int v = 0; v < N; v++) mask |= Mask(where[v].words[w] >> (cell & 63) & 1) << v;
+      cells[cell] = mask;
+    }
+  }
+  bool previous = propagation;
+  propagation = false;
+  for(int cell = 0; cell < CELLS; cell++)
+  {
+    if(cells[cell] != board.cells[cell]) WriteCell(cell, cells[cell]);
   }
+  propagation = previous;
+  board.synced = true;
+  placed[0] = found[0];
+  placed[1] = found[1];
+  return filled == CELLS;
 }
 
-int Sudoku::FindXWing() {
-    int changed = 0;
-
-    // Helper to count how many times a value appears as candidate in a row/column
-    auto countCandidatesInRow = [this](int row, int val) -> std::vector<int> {
-        std::vector<int> positions;
-        for(int col = 0; col < 9; col++) {
-            if(GetValue(row, col) == -1 && board[row][col][val] == val) {
-                positions.push_back(col);
-            }
-        }
-        return positions;
-    };
-
-    auto countCandidatesInCol = [this](int col, int val) -> std::vector<int> {
-        std::vector<int> positions;
-        for(int row = 0; row < 9; row++) {
-            if(GetValue(row, col) == -1 && board[row][col][val] == val) {
-                positions.push_back(row);
-            }
-        }
-        return positions;
-    };
-
-    // For each value 1-9
-    for(int val = 0; val < 9; val++) {
-        // Check row-based X-Wing
-        for(int row1 = 0; row1 < 8; row1++) {
-            std::vector<int> cols1 = countCandidatesInRow(row1, val);
-            if(cols1.size() != 2) continue;  // Need exactly 2 positions
-
-            for(int row2 = row1 + 1; row2 < 9; row2++) {
-                std::vector<int> cols2 = countCandidatesInRow(row2, val);
-                if(cols2.size() != 2) continue;
+template<int Box>
+size_t BasicSudoku<Box>::Mark()
+{
+  if(marks++ == 0) trailSize = 0;
+  trailing = true;
+  return trailSize;
+}
 
-                // Check if columns match
-                if(cols1[0] == cols2[0] && cols1[1] == cols2[1]) {
-                    print_debug("Found X-Wing pattern for value %d in rows %d and %d at columns %d,%d\n",
-                              val + 1, row1 + 1, row2 + 1, cols1[0] + 1, cols1[1] + 1);
+// Replay the journal backwards to the mark. The mark stays open, so the
+// caller can try again from the same point before committing.
+template<int Box>
+void BasicSudoku<Box>::Rollback(size_t mark)
+{
+  bool wasTrailing = trailing;
+  trailing = false;
+  const SearchTrail<Box>& journal = trail.Get();
+  while(trailSize > (int)mark)
+  {
+    trailSize--;
+    WriteCell(journal.cells[trailSize], journal.masks[trailSize]);
+  }
+  pendingCount = 0;
+  trailing = wasTrailing;
+}
 
-                    // Found X-Wing pattern - eliminate val from other cells in these columns
-                    bool madeChange = false;
-                    for(int col : {cols1[0], cols1[1]}) {
-                        for(int row = 0; row < 9; row++) {
-                            if(row != row1 && row != row2 && 
-                               GetValue(row, col) == -1 && 
-                               board[row][col][val] == val) {
-                                board[row][col][val] = -1;
-                                madeChange = true;
-                                print_debug("X-Wing: eliminated %d from (%d,%d)\n",
-                                          val + 1, row + 1, col + 1);
-                            }
-                        }
-                    }
-                    if(madeChange) changed++;
-                }
-            }
-        }
+template<int Box>
+void BasicSudoku<Box>::Commit()
+{
+  if(marks > 0 && --marks == 0)
+  {
+    trailing = false;
+    trailSize = 0;
+  }
+}
 
-        // Check column-based X-Wing
-        for(int col1 = 0; col1 < 8; col1++) {
-            std::vector<int> rows1 = countCandidatesInCol(col1, val);
-            if(rows1.size() != 2) continue;
+template<int Box>
+int BasicSudoku<Box>::CountSolutions(int limit)
+{
+  return ExactCover(limit, false);
+}
 
-            for(int col2 = col1 + 1; col2 < 9; col2++) {
-                std::vector<int> rows2 = countCandidatesInCol(col2, val);
-                if(rows2.size() != 2) continue;
+template<int Box>
+bool BasicSudoku<Box>::SolveExact()
+{
+  return ExactCover(1, true) > 0;
+}
 
-                // Check if rows match
-                if(rows1[0] == rows2[0] && rows1[1] == rows2[1]) {
-                    print_debug("Found X-Wing pattern for value %d in columns %d and %d at rows %d,%d\n",
-                              val + 1, col1 + 1, col2 + 1, rows1[0] + 1, rows1[1] + 1);
+template<int Box>
+bool BasicSudoku<Box>::IsSolved()
+{
+  return board.filled == CELLS && board.conflicts == 0;
+}
 
-                    // Found X-Wing pattern - eliminate val from other cells in these rows
-                    bool madeChange = false;
-                    for(int row : {rows1[0], rows1[1]}) {
-                        for(int col = 0; col < 9; col++) {
-                            if(col != col1 && col != col2 && 
-                               GetValue(row, col) == -1 && 
-                               board[row][col][val] == val) {
-                                board[row][col][val] = -1;
-                                madeChange = true;
-                                print_debug("X-Wing: eliminated %d from (%d,%d)\n",
-                                          val + 1, row + 1, col + 1);
-                            }
-                        }
-                    }
-                    if(madeChange) changed++;
-                }
-            }
-        }
-    }
+template<int Box>
+int BasicSudoku<Box>::EliminatePossibility(int x, int y, int value)
+{
+  if(x>=0 && x<N && y>=0 && y<N && value>=0 && value<N)
+  {
+    int cell = x * N + y;
+    WriteCell(cell, board.cells[cell] & ~(Mask(1) << value));
+    Propagate();
+    return 0;
+  }
+  else
+  {
+    return -1;
+  }
+}
 
-    return changed;
+template<int Box>
+bool BasicSudoku<Box>::LegalValue(int x, int y, int value)
+{
+  if(x>=0 && x<N && y>=0 && y<N && value>=0 && value<N)
+  {
+    // Peers hold the value if a unit counts it anywhere but this cell
+    const auto* units=GRID<Box>.cellUnits[x * N + y];
+    int own=(GetValue(x, y)==value) ? 1 : 0;
+    return board.counts[units[0]][value]<=own &&
+           board.counts[units[1]][value]<=own &&
+           board.counts[units[2]][value]<=own;
+  }
+  else
+  {
+    return false;
+  }
 }
 
-int Sudoku::FindSwordFish() {
+// Fish of the given size on each value: size base lines (rows, then
+// columns) whose candidates for the value all fall in size cover lines of
+// the other direction. The value then can't go anywhere else in the cover
+// lines. A finned fish also has fins, base candidates outside the cover
+// that all sit in one box; if a fin holds the value that box can't have it
+// elsewhere, so eliminations are limited to cover cells in the fin box.
+// Sashimi fish, where a fin stands in for a base candidate, fall out of the
+// same search.
+template<int Box>
+int BasicSudoku<Box>::FindFish(int size, bool finned) {
+    if(size < 2 || size > 4 || size > N / 2) return 0;
+    SolveTechnique technique = finned ? TECH_FINNED_FISH :
+        size == 2 ? TECH_X_WING : size == 3 ? TECH_SWORDFISH : TECH_JELLYFISH;
+    const Mask band = (Mask(1) << Box) - 1;
     int changed = 0;
 
-    // Helper to check if a cell can have a value
-    auto isCandidate = [this](int row, int col, int val) -> bool {
-        return GetValue(row, col) == -1 && 
-               board[row][col][val] == val && 
-               LegalValue(row, col, val);
-    };
-
-    // Helper to validate elimination
-    auto isSafeElimination = [this](int row, int col, int val) -> bool {
-        if(GetValue(row, col) != -1) return false;
-        if(board[row][col][val] != val) return false;
-        
-        // Count remaining candidates
-        int candidateCount = 0;
-        for(int v = 0; v < 9; v++) {
-            if(board[row][col][v] == v && LegalValue(row, col, v)) {
-                candidateCount++;
-            }
-        }
-        return candidateCount > 1;
-    };
-
-    // Process row-based Swordfish
-    for(int val = 0; val < 9; val++) {
-        // Get candidate positions for each row
-        std::vector<std::vector<int>> rowPositions(9);
-        for(int row = 0; row < 9; row++) {
-            for(int col = 0; col < 9; col++) {
-                if(isCandidate(row, col, val)) {
-                    rowPositions[row].push_back(col);
+    // Remove val from the open cells where the lines cross the cover
+    auto eliminate = [this, technique](int dir, Mask lines, Mask cover, int val) -> bool {
+        bool madeChange = false;
+        for(Mask rest = lines; rest; rest &= rest - 1) {
+            const auto* cells = GRID<Box>.unitCells[dir * N + LowestBit(rest)];
+            for(Mask c = cover; c; c &= c - 1) {
+                int cell = cells[LowestBit(c)];
+                Mask mask = board.cells[cell];
+                if(((mask >> val) & 1) && (mask & (mask - 1))) {
+                    EliminatePossibility(cell / N, cell % N, val);
+                    Trace(TRACE_ELIMINATE, technique, cell, val);
+                    madeChange = true;
                 }
             }
         }
+        return madeChange;
+    };
 
-        // Try each triplet of rows
-        for(int row1 = 0; row1 < 7; row1++) {
-            if(rowPositions[row1].size() < 2 || rowPositions[row1].size() > 3) continue;
-            
-            for(int row2 = row1 + 1; row2 < 8; row2++) {
-                if(rowPositions[row2].size() < 2 || rowPositions[row2].size() > 3) continue;
-                
-                for(int row3 = row2 + 1; row3 < 9; row3++) {
-                    if(rowPositions[row3].size() < 2 || rowPositions[row3].size() > 3) continue;
-
-                    // Collect unique columns
-                    std::set<int> uniqueCols;
-                    for(int col : rowPositions[row1]) uniqueCols.insert(col);
-                    for(int col : rowPositions[row2]) uniqueCols.insert(col);
-                    for(int col : rowPositions[row3]) uniqueCols.insert(col);
-
-                    // Check for Swordfish pattern
-                    if(uniqueCols.size() == 3) {
-                        // Make eliminations
-                        bool madeChange = false;
-                        int backup[9][9][9];
-                        std::memcpy(backup, board, sizeof(backup));
-
-                        // Eliminate from other rows in these columns
-                        for(int col : uniqueCols) {
-                            for(int row = 0; row < 9; row++) {
-                                if(row != row1 && row != row2 && row != row3 &&
-                                   isSafeElimination(row, col, val)) {
-                                    board[row][col][val] = -1;
-                                    madeChange = true;
-                                }
-                            }
-                        }
-
-                        // Validate changes
-                        if(madeChange) {
-                            if(!IsValidSolution()) {
-                                std::memcpy(board, backup, sizeof(backup));
-                            } else {
-                                changed++;
-                            }
-                        }
+    for(int val = 0; val < N; val++) {
+        for(int dir = 0; dir < 2; dir++) {
+            // positions[line] has bit i set when the line can take the value
+            // at its i-th cell, which is where it crosses cover line i.
+            // Eliminations only shrink these, so a fish found on the masks
+            // built here still holds after earlier ones.
+            Mask positions[N];
+            int lines[N];
+            int count = 0;
+            for(int line = 0; line < N; line++) {
+                positions[line] = 0;
+                for(int i = 0; i < N; i++) {
+                    if((CellCandidates(GRID<Box>.unitCells[dir * N + line][i]) >> val) & 1) {
+                        positions[line] |= Mask(1) << i;
                     }
                 }
-            }
-        }
-    }
-
-    // Process column-based Swordfish
-    for(int val = 0; val < 9; val++) {
-        // Get candidate positions for each column
-        std::vector<std::vector<int>> colPositions(9);
-        for(int col = 0; col < 9; col++) {
-            for(int row = 0; row < 9; row++) {
-                if(isCandidate(row, col, val)) {
-                    colPositions[col].push_back(row);
+                int found = BitCount(positions[line]);
+                if(found >= 1 && found <= (finned ? size + Box : size)) lines[count++] = line;
+            }
+            if(count < size) continue;
+
+            // Each combination of base lines is a bit pattern over lines[],
+            // stepped to the next with the same bit count
+            unsigned long long end = 1ULL << count;
+            unsigned long long combo = (1ULL << size) - 1;
+            for(; combo < end; combo = NextCombination(combo)) {
+                Mask base = 0, cover = 0;
+                for(unsigned long long rest = combo; rest; rest &= rest - 1) {
+                    int line = lines[LowestBit(rest)];
+                    base |= Mask(1) << line;
+                    cover |= positions[line];
                 }
-            }
-        }
-
-        // Try each triplet of columns
-        for(int col1 = 0; col1 < 7; col1++) {
-            if(colPositions[col1].size() < 2 || colPositions[col1].size() > 3) continue;
-            
-            for(int col2 = col1 + 1; col2 < 8; col2++) {
-                if(colPositions[col2].size() < 2 || colPositions[col2].size() > 3) continue;
-                
-                for(int col3 = col2 + 1; col3 < 9; col3++) {
-                    if(colPositions[col3].size() < 2 || colPositions[col3].size() > 3) continue;
-
-                    // Collect unique rows
-                    std::set<int> uniqueRows;
-                    for(int row : colPositions[col1]) uniqueRows.insert(row);
-                    for(int row : colPositions[col2]) uniqueRows.insert(row);
-                    for(int row : colPositions[col3]) uniqueRows.insert(row);
-
-                    // Check for Swordfish pattern
-                    if(uniqueRows.size() == 3) {
-                        // Make eliminations
-                        bool madeChange = false;
-                        int backup[9][9][9];
-                        std::memcpy(backup, board, sizeof(backup));
-
-                        // Eliminate from other columns in these rows
-                        for(int row : uniqueRows) {
-                            for(int col = 0; col < 9; col++) {
-                                if(col != col1 && col != col2 && col != col3 &&
-                                   isSafeElimination(row, col, val)) {
-                                    board[row][col][val] = -1;
-                                    madeChange = true;
-                                }
-                            }
-                        }
+                int spread = BitCount(cover);
 
-                        // Validate changes
-                        if(madeChange) {
-                            if(!IsValidSolution()) {
-                                std::memcpy(board, backup, sizeof(backup));
-                            } else {
-                                changed++;
-                            }
+                if(!finned) {
+                    if(spread != size) continue;
+                    Trace(TRACE_PATTERN, technique, GRID<Box>.unitCells[dir * N + LowestBit(base)][LowestBit(cover)], val, "fish");
+                    if(eliminate(dir, ALL_CANDIDATES & ~base, cover, val)) changed++;
+                    continue;
+                }
+                if(spread <= size) continue;
+
+                // Try each box as the home of the fins. Base candidates
+                // outside it must fit in the cover; if there is room left
+                // over, any of the box's own positions can join the cover.
+                for(int lineBand = 0; lineBand < Box; lineBand++) {
+                    Mask boxLines = band << (lineBand * Box);
+                    if(!(base & boxLines)) continue;
+
+                    for(int posBand = 0; posBand < Box; posBand++) {
+                        Mask boxPositions = band << (posBand * Box);
+                        Mask outside = 0;
+                        for(Mask rest = base; rest; rest &= rest - 1) {
+                            int line = LowestBit(rest);
+                            outside |= positions[line] & ~(((boxLines >> line) & 1) ? boxPositions : Mask(0));
                         }
+                        int fixed = BitCount(outside);
+                        if(fixed > size) continue;
+
+                        Mask targets = (fixed < size) ? boxPositions : Mask(outside & boxPositions);
+                        if(!targets) continue;
+                        Trace(TRACE_PATTERN, technique,
+                              GRID<Box>.unitCells[dir * N + LowestBit(base)][LowestBit(cover)], val, "finned fish");
+                        if(eliminate(dir, boxLines & ~base, targets, val)) changed++;
                     }
                 }
             }
@@ -957,1278 +1885,1178 @@ int Sudoku::FindSwordFish() {
     return changed;
 }
 
-int Sudoku::FindHiddenPairs() {
-    int changed = 0;
-    
-    // For each unit (row, column, box)
-    for(int unit = 0; unit < 27; unit++) {
-        // Try each pair of values
-        for(int val1 = 0; val1 < 8; val1++) {
-            for(int val2 = val1 + 1; val2 < 9; val2++) {
-                std::vector<std::pair<int, int>> positions;
-                
-                // Get coordinates for the current unit
-                for(int pos = 0; pos < 9; pos++) {
-                    int x, y;
-                    if(unit < 9) {  // Row
-                        x = unit;
-                        y = pos;
-                    } else if(unit < 18) {  // Column
-                        x = pos;
-                        y = unit - 9;
-                    } else {  // Box
-                        int box = unit - 18;
-                        x = (box / 3) * 3 + pos / 3;
-                        y = (box % 3) * 3 + pos % 3;
-                    }
-                    
-                    // If cell is empty and can contain either val1 or val2
-                    if(GetValue(x, y) == -1 && 
-                       (board[x][y][val1] == val1 || board[x][y][val2] == val2)) {
-                        // Verify both values are still possible in this cell
-                        bool canHaveVal1 = board[x][y][val1] == val1;
-                        bool canHaveVal2 = board[x][y][val2] == val2;
-                        if(canHaveVal1 || canHaveVal2) {
-                            positions.push_back({x, y});
-                        }
-                    }
-                }
-                
-                // If exactly two cells can contain these values
-                if(positions.size() == 2) {
-                    // Verify both cells can actually contain both values
-                    bool validPair = true;
-                    for(const auto& pos : positions) {
-                        if(board[pos.first][pos.second][val1] == -1 || 
-                           board[pos.first][pos.second][val2] == -1) {
-                            validPair = false;
-                            break;
-                        }
-                    }
-                    
-                    if(validPair) {
-                        // Clear all other candidates from these two cells
-                        bool madeChange = false;
-                        for(const auto& pos : positions) {
-                            for(int v = 0; v < 9; v++) {
-                                if(v != val1 && v != val2 && 
-                                   board[pos.first][pos.second][v] != -1) {
-                                    board[pos.first][pos.second][v] = -1;
-                                    madeChange = true;
-                                }
-                            }
-                        }
-                        if(madeChange) changed++;
-                    }
-                }
-            }
-        }
-    }
-    
-    return changed;
+template<int Box>
+int BasicSudoku<Box>::FindXWing() {
+    return FindFish(2, false);
 }
 
-int Sudoku::StdElim() {
-    int eliminated = 0;
-
-    // Process each cell
-    for(int y = 0; y < 9; y++) {
-        for(int x = 0; x < 9; x++) {
-            // Skip if cell is empty
-            if(GetValue(x, y) == -1) continue;
-            
-            int value = GetValue(x, y);
-            
-            // Eliminate from row
-            for(int col = 0; col < 9; col++) {
-                if(col != x && GetValue(col, y) == -1) {
-                    if(board[col][y][value] == value) {
-                        board[col][y][value] = -1;  // Eliminate the possibility
-                        eliminated++;
-                        print_debug("Eliminated %d from (%d,%d) - same row as (%d,%d)\n", 
-                                  value + 1, col + 1, y + 1, x + 1, y + 1);
-                    }
-                }
-            }
-            
-            // Eliminate from column
-            for(int row = 0; row < 9; row++) {
-                if(row != y && GetValue(x, row) == -1) {
-                    if(board[x][row][value] == value) {
-                        board[x][row][value] = -1;  // Eliminate the possibility
-                        eliminated++;
-                        print_debug("Eliminated %d from (%d,%d) - same column as (%d,%d)\n", 
-                                  value + 1, x + 1, row + 1, x + 1, y + 1);
-                    }
-                }
-            }
-            
-            // Eliminate from 3x3 box
-            int box_x = (x / 3) * 3;
-            int box_y = (y / 3) * 3;
-            for(int i = 0; i < 3; i++) {
-                for(int j = 0; j < 3; j++) {
-                    int cur_x = box_x + j;
-                    int cur_y = box_y + i;
-                    if((cur_x != x || cur_y != y) && GetValue(cur_x, cur_y) == -1) {
-                        if(board[cur_x][cur_y][value] == value) {
-                            board[cur_x][cur_y][value] = -1;  // Eliminate the possibility
-                            eliminated++;
-                            print_debug("Eliminated %d from (%d,%d) - same box as (%d,%d)\n", 
-                                      value + 1, cur_x + 1, cur_y + 1, x + 1, y + 1);
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    // After each pass, verify the board is still valid
-    if(!IsValidSolution()) {
-        print_debug("Invalid board state after standard elimination\n");
-        return -1;
-    }
+template<int Box>
+int BasicSudoku<Box>::FindSwordFish() {
+    return FindFish(3, false);
+}
 
-    print_debug("Standard elimination completed: %d candidates eliminated\n", eliminated);
-    return eliminated > 0 ? eliminated : -1;
+template<int Box>
+int BasicSudoku<Box>::FindJellyfish() {
+    return FindFish(4, false);
 }
 
-int Sudoku::FindHiddenSingles() {
+// Finned and sashimi X-Wings, Swordfish and Jellyfish, smallest first
+template<int Box>
+int BasicSudoku<Box>::FindFinnedFish() {
     int changed = 0;
-    
-    // Helper function to log potential moves
-    //auto logMove = [](const char* unitType, int unit, int val, int pos) {
-    auto logMove = [this](const char* unitType, int unit, int val, int pos) {
-        print_debug("Found hidden single: value %d in %s %d at position %d\n", 
-               val + 1, unitType, unit + 1, pos + 1);
-    };
+    for(int size = 2; size <= 4; size++) {
+        changed += FindFish(size, true);
+    }
+    return changed;
+}
 
-    // Helper function to validate before setting
-    auto validateMove = [this](int row, int col, int val) -> bool {
-        // Check row
-        for(int c = 0; c < 9; c++) {
-            if(c != col && GetValue(row, c) == val) {
-                print_debug("Row conflict: %d already exists in row %d\n", val + 1, row + 1);
-                return false;
-            }
-        }
-        
-        // Check column
-        for(int r = 0; r < 9; r++) {
-            if(r != row && GetValue(r, col) == val) {
-                print_debug("Column conflict: %d already exists in column %d\n", val + 1, col + 1);
-                return false;
-            }
-        }
-        
-        // Check box
-        int boxRow = (row / 3) * 3;
-        int boxCol = (col / 3) * 3;
-        for(int r = 0; r < 3; r++) {
-            for(int c = 0; c < 3; c++) {
-                if((boxRow + r != row || boxCol + c != col) && 
-                   GetValue(boxRow + r, boxCol + c) == val) {
-                    print_debug("Box conflict: %d already exists in box\n", val + 1);
-                    return false;
-                }
-            }
-        }
-        return true;
-    };
+// Naked and hidden subsets of minSize to maxSize cells in every unit. A
+// naked subset is size open cells whose candidates are only size values
+// between them: those values go in those cells, so the rest of the unit
+// can't take them. A hidden subset is size values whose places in the unit
+// are only size cells: those cells hold those values, so they lose every
+// other candidate. Both are found by combining the unit's N-bit masks,
+// cells by candidates or values by places, and keeping the combinations
+// whose union has size bits.
+template<int Box>
+int BasicSudoku<Box>::FindSubsets(int minSize, int maxSize, bool hidden) {
+    if(minSize < 2) minSize = 2;
+    if(maxSize > 4) maxSize = 4;
+    int changed = 0;
 
-    // First scan rows
-    for(int row = 0; row < 9; row++) {
-        for(int val = 0; val < 9; val++) {
-            int validCol = -1;
-            int count = 0;
-            
-            // Count how many times this value can appear in this row
-            for(int col = 0; col < 9; col++) {
-                if(GetValue(row, col) == -1 && board[row][col][val] == val) {
-                    count++;
-                    validCol = col;
-                }
-            }
-            
-            // Found a hidden single
-            if(count == 1 && validCol != -1) {
-                logMove("row", row, val, validCol);
-                
-                // Validate before making the change
-                if(validateMove(row, validCol, val)) {
-                    SetValue(row, validCol, val);
-                    if(!IsValidSolution()) {
-                        print_debug("Invalid solution after setting %d at (%d,%d)\n", 
-                              val + 1, row + 1, validCol + 1);
-                        return -1;
-                    }
-                    changed++;
-                }
-            }
-        }
-    }
-    
-    // Then scan columns
-    for(int col = 0; col < 9; col++) {
-        for(int val = 0; val < 9; val++) {
-            int validRow = -1;
-            int count = 0;
-            
-            for(int row = 0; row < 9; row++) {
-                if(GetValue(row, col) == -1 && board[row][col][val] == val) {
-                    count++;
-                    validRow = row;
+    for(int unit = 0; unit < UNITS; unit++) {
+        // Rescan the unit after each change, since placements made by
+        // propagation can empty a cell's mask
+        bool rescan = true;
+        while(rescan) {
+            rescan = false;
+
+            // cands[i] is the candidates of the cell at unit position i and
+            // where[v] the positions that can take v
+            Mask cands[N], where[N] = {};
+            int open = 0;
+            for(int i = 0; i < N; i++) {
+                cands[i] = CellCandidates(GRID<Box>.unitCells[unit][i]);
+                if(cands[i]) open++;
+                if(!hidden) continue;
+                for(Mask rest = cands[i]; rest; rest &= rest - 1) {
+                    where[LowestBit(rest)] |= Mask(1) << i;
                 }
             }
-            
-            if(count == 1 && validRow != -1) {
-                logMove("column", col, val, validRow);
-                
-                if(validateMove(validRow, col, val)) {
-                    SetValue(validRow, col, val);
-                    if(!IsValidSolution()) {
-                        print_debug("Invalid solution after setting %d at (%d,%d)\n", 
-                              val + 1, validRow + 1, col + 1);
-                        return -1;
+            const Mask* masks = hidden ? where : cands;
+
+            // A subset as large as the open part of the unit leaves nothing
+            // to clear
+            for(int size = minSize; size <= maxSize && size < open && !rescan; size++) {
+                SolveTechnique technique = !hidden ? TECH_NAKED_SETS
+                                         : size == 2 ? TECH_HIDDEN_PAIRS : TECH_HIDDEN_SETS;
+
+                // Only masks of size bits or fewer can be part of a subset
+                Mask items[N];
+                int index[N];
+                int count = 0;
+                for(int i = 0; i < N; i++) {
+                    if(masks[i] && BitCount(masks[i]) <= size) {
+                        items[count] = masks[i];
+                        index[count++] = i;
                     }
-                    changed++;
                 }
-            }
-        }
-    }
-    
-    // Finally scan boxes
-    for(int box = 0; box < 9; box++) {
-        int boxRow = (box / 3) * 3;
-        int boxCol = (box % 3) * 3;
-        
-        for(int val = 0; val < 9; val++) {
-            int validRow = -1;
-            int validCol = -1;
-            int count = 0;
-            
-            for(int r = 0; r < 3; r++) {
-                for(int c = 0; c < 3; c++) {
-                    int row = boxRow + r;
-                    int col = boxCol + c;
-                    if(GetValue(row, col) == -1 && board[row][col][val] == val) {
-                        count++;
-                        validRow = row;
-                        validCol = col;
+
+                unsigned long long end = 1ULL << count;
+                for(unsigned long long combo = (1ULL << size) - 1; combo < end && !rescan;
+                    combo = NextCombination(combo)) {
+                    Mask chosen = 0, covered = 0;
+                    for(unsigned long long rest = combo; rest; rest &= rest - 1) {
+                        int k = LowestBit(rest);
+                        chosen |= Mask(1) << index[k];
+                        covered |= items[k];
                     }
-                }
-            }
-            
-            if(count == 1 && validRow != -1 && validCol != -1) {
-                logMove("box", box, val, (validRow % 3) * 3 + (validCol % 3));
-                
-                if(validateMove(validRow, validCol, val)) {
-                    SetValue(validRow, validCol, val);
-                    if(!IsValidSolution()) {
-                        print_debug("Invalid solution after setting %d at (%d,%d)\n", 
-                              val + 1, validRow + 1, validCol + 1);
-                        return -1;
+                    if(BitCount(covered) != size) continue;
+
+                    // Naked: the chosen cells' values leave the other cells.
+                    // Hidden: the covered cells keep only the chosen values.
+                    Mask cells = hidden ? covered : Mask(ALL_CANDIDATES & ~chosen);
+                    Mask values = hidden ? Mask(ALL_CANDIDATES & ~chosen) : covered;
+                    int source = GRID<Box>.unitCells[unit][LowestBit(hidden ? covered : chosen)];
+                    for(Mask rest = cells; rest; rest &= rest - 1) {
+                        int pos = LowestBit(rest);
+                        int cell = GRID<Box>.unitCells[unit][pos];
+                        for(Mask drop = cands[pos] & values; drop; drop &= drop - 1) {
+                            Mask mask = board.cells[cell];
+                            int val = LowestBit(drop);
+                            if(!((mask >> val) & 1) || !(mask & (mask - 1))) continue;
+                            EliminatePossibility(cell / N, cell % N, val);
+                            Trace(TRACE_ELIMINATE, technique, cell, val,
+                                  hidden ? "outside a hidden subset's values" : "taken by a naked subset", source);
+                            rescan = true;
+                        }
                     }
-                    changed++;
+                    if(rescan) changed++;
                 }
             }
         }
     }
-    
+
     return changed;
 }
 
-int Sudoku::LinElim() {
-    int changed = 0;
-    
-    // Helper to safely eliminate a candidate and track changes
-    auto eliminateCandidate = [this](int x, int y, int val, const char* reason) -> bool {
-        if(GetValue(x, y) == -1 && board[x][y][val] == val) {
-            // Count remaining candidates before elimination
-            int candidateCount = 0;
-            for(int v = 0; v < 9; v++) {
-                if(board[x][y][v] == v) candidateCount++;
-            }
-            if(candidateCount <= 1) return false; // Don't eliminate last candidate
-            
-            board[x][y][val] = -1;
-            print_debug("Eliminated %d from (%d,%d) - %s\n", 
-                       val + 1, x + 1, y + 1, reason);
-            return true;
-        }
-        return false;
-    };
-
-    // Process each value 1-9
-    for(int val = 0; val < 9; val++) {
-        // Check 3x3 boxes
-        for(int boxRow = 0; boxRow < 9; boxRow += 3) {
-            for(int boxCol = 0; boxCol < 9; boxCol += 3) {
-                // First pass: find if value appears in box or is constrained to a line
-                bool valueInBox = false;
-                std::vector<std::pair<int,int>> candidates;
-                
-                for(int i = 0; i < 3; i++) {
-                    for(int j = 0; j < 3; j++) {
-                        int x = boxCol + j;
-                        int y = boxRow + i;
-                        if(GetValue(x, y) == val) {
-                            valueInBox = true;
-                            break;
-                        }
-                        if(GetValue(x, y) == -1 && board[x][y][val] == val && LegalValue(x, y, val)) {
-                            candidates.push_back({x, y});
-                        }
-                    }
-                }
-
-                // Check if all candidates are in same row or column
-                if(!valueInBox && candidates.size() >= 2) {
-                    bool sameRow = true;
-                    bool sameCol = true;
-                    int firstRow = candidates[0].second;
-                    int firstCol = candidates[0].first;
-                    
-                    for(const auto& pos : candidates) {
-                        if(pos.second != firstRow) sameRow = false;
-                        if(pos.first != firstCol) sameCol = false;
-                    }
-                    
-                    // If confined to a line, eliminate from rest of line outside box
-                    if(sameRow) {
-                        for(int col = 0; col < 9; col++) {
-                            if(col < boxCol || col >= boxCol + 3) {  // Outside box
-                                if(eliminateCandidate(col, firstRow, val, 
-                                   "value confined to box row")) {
-                                    changed++;
-                                }
-                            }
-                        }
-                    }
-                    if(sameCol) {
-                        for(int row = 0; row < 9; row++) {
-                            if(row < boxRow || row >= boxRow + 3) {  // Outside box
-                                if(eliminateCandidate(firstCol, row, val,
-                                   "value confined to box column")) {
-                                    changed++;
-                                }
-                            }
-                        }
-                    }
-                }
+template<int Box>
+int BasicSudoku<Box>::FindHiddenPairs() {
+    return FindSubsets(2, 2, true);
+}
 
-                // Look for single candidate in box
-                if(!valueInBox && candidates.size() == 1) {
-                    int x = candidates[0].first;
-                    int y = candidates[0].second;
-                    if(LegalValue(x, y, val)) {
-                        print_debug("Box at (%d,%d): Only cell (%d,%d) can be %d\n",
-                                  boxCol/3 + 1, boxRow/3 + 1, x + 1, y + 1, val + 1);
-                        SetValue(x, y, val);
-                        changed++;
-                    }
-                }
-            }
-        }
+// Hidden triples and quads
+template<int Box>
+int BasicSudoku<Box>::FindHiddenSets() {
+    return FindSubsets(3, 4, true);
+}
 
-        // Check rows for line elimination
-        for(int row = 0; row < 9; row++) {
-            std::vector<int> possibilities;
-            bool valueInRow = false;
-            
-            // Find all possible positions in row
-            for(int col = 0; col < 9; col++) {
-                if(GetValue(col, row) == val) {
-                    valueInRow = true;
-                    break;
-                }
-                if(GetValue(col, row) == -1 && board[col][row][val] == val && LegalValue(col, row, val)) {
-                    possibilities.push_back(col);
-                }
-            }
+template<int Box>
+int BasicSudoku<Box>::FindNakedSets() {
+    return FindSubsets(2, 4, false);
+}
 
-            // If value confined to one box in row, eliminate from rest of that box
-            if(!valueInRow && possibilities.size() >= 2) {
-                bool allInOneBox = true;
-                int boxStart = possibilities[0] / 3;
-                for(int col : possibilities) {
-                    if(col / 3 != boxStart) {
-                        allInOneBox = false;
-                        break;
-                    }
-                }
-                
-                if(allInOneBox) {
-                    int boxCol = boxStart * 3;
-                    for(int i = 0; i < 3; i++) {
-                        for(int rowInBox = row/3*3; rowInBox < row/3*3 + 3; rowInBox++) {
-                            if(rowInBox != row) {
-                                if(eliminateCandidate(boxCol + i, rowInBox, val,
-                                   "value confined to row in box")) {
-                                    changed++;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+template<int Box>
+int BasicSudoku<Box>::StdElim() {
+    int eliminated = 0;
 
-            // Place single candidate in row
-            if(!valueInRow && possibilities.size() == 1) {
-                int col = possibilities[0];
-                print_debug("Row %d: Only cell (%d,%d) can be %d\n",
-                          row + 1, col + 1, row + 1, val + 1);
-                SetValue(col, row, val);
-                changed++;
-            }
+    if(propagation) {
+        // Placements already reach their peers as they happen; only a board
+        // edited while propagation was off needs one full sweep to catch up
+        if(board.synced) {
+            return -1;
         }
-
-        // Check columns similarly
-        for(int col = 0; col < 9; col++) {
-            std::vector<int> possibilities;
-            bool valueInCol = false;
-            
-            for(int row = 0; row < 9; row++) {
-                if(GetValue(col, row) == val) {
-                    valueInCol = true;
-                    break;
-                }
-                if(GetValue(col, row) == -1 && board[col][row][val] == val && LegalValue(col, row, val)) {
-                    possibilities.push_back(row);
-                }
+        for(int cell = 0; cell < CELLS; cell++) {
+            if(MaskValue(board.cells[cell]) >= 0 && pendingCount < CELLS) {
+                pending[pendingCount++] = cell;
             }
+        }
+        eliminated = Propagate();
+        board.synced = true;
 
-            // If value confined to one box in column, eliminate from rest of that box
-            if(!valueInCol && possibilities.size() >= 2) {
-                bool allInOneBox = true;
-                int boxStart = possibilities[0] / 3;
-                for(int row : possibilities) {
-                    if(row / 3 != boxStart) {
-                        allInOneBox = false;
-                        break;
-                    }
-                }
-                
-                if(allInOneBox) {
-                    int boxRow = boxStart * 3;
-                    for(int i = 0; i < 3; i++) {
-                        for(int colInBox = col/3*3; colInBox < col/3*3 + 3; colInBox++) {
-                            if(colInBox != col) {
-                                if(eliminateCandidate(colInBox, boxRow + i, val,
-                                   "value confined to column in box")) {
-                                    changed++;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+        if(!IsValidSolution()) {
+            print_debug("Invalid board state after standard elimination\n");
+            return -1;
+        }
+        return eliminated > 0 ? eliminated : -1;
+    }
 
-            // Place single candidate in column
-            if(!valueInCol && possibilities.size() == 1) {
-                int row = possibilities[0];
-                print_debug("Column %d: Only cell (%d,%d) can be %d\n",
-                          col + 1, col + 1, row + 1, val + 1);
-                SetValue(col, row, val);
-                changed++;
+    // Process each cell
+    for(int y = 0; y < N; y++) {
+        for(int x = 0; x < N; x++) {
+            // Skip if cell is empty
+            if(GetValue(x, y) == -1) continue;
+            
+            int value = GetValue(x, y);
+            
+            // Eliminate from the row, column and box
+            for(int i = 0; i < GridTables<Box>::PEERS; i++) {
+                int peer = GRID<Box>.peers[x * N + y][i];
+                int px = peer / N, py = peer % N;
+                if(GetValue(px, py) == -1 && IsCandidate(px, py, value)) {
+                    EliminatePossibility(px, py, value);  // Eliminate the possibility
+                    eliminated++;
+                    Trace(TRACE_ELIMINATE, TECH_STD_ELIM, peer, value, "peer of", x * N + y);
+                }
             }
         }
     }
     
+    // After each pass, verify the board is still valid
     if(!IsValidSolution()) {
-        print_debug("Invalid solution after line elimination\n");
+        print_debug("Invalid board state after standard elimination\n");
         return -1;
     }
-    
-    print_debug("Line elimination completed: %d changes made\n", changed);
-    
-    return changed;
-}
 
-std::vector<int> Sudoku::GetCellCandidates(int x, int y) {
-    std::vector<int> candidates;
-    if(GetValue(x, y) != -1) return candidates;  // Return empty if cell is filled
-    
-    for(int val = 0; val < 9; val++) {
-        if(board[x][y][val] == val && LegalValue(x, y, val)) {
-            candidates.push_back(val);
-        }
-    }
-    return candidates;
+    return eliminated > 0 ? eliminated : -1;
 }
 
+template<int Box>
+int BasicSudoku<Box>::FindHiddenSingles() {
+    int changed = 0;
+    int counted = -1;
+
+    // Scan rows, then columns, then boxes
+    for(int unit = 0; unit < UNITS; unit++) {
+        // Placements change the counts, so refresh the table after each one
+        if(counted != changed) {
+            CountPlaces();
+            counted = changed;
+        }
 
-bool Sudoku::VectorsEqual(const std::vector<int>& v1, const std::vector<int>& v2) {
-    if(v1.size() != v2.size()) return false;
-    for(size_t i = 0; i < v1.size(); i++) {
-        if(v1[i] != v2[i]) return false;
-    }
-    return true;
-}
+        for(int val = 0; val < N; val++) {
+            if(places[unit][val] != 1) continue;
 
-void Sudoku::FindNakedSetInUnit(std::vector<std::pair<int, int>>& cells, const std::vector<int>& candidates, int& changed) {
-    for(auto& cell : cells) {
-        int x = cell.first;
-        int y = cell.second;
-        
-        std::vector<int> cellCandidates = GetCellCandidates(x, y);
-        if(!VectorsEqual(cellCandidates, candidates)) {
-            for(int val : candidates) {
-                if(board[x][y][val] != -1) {
-                    board[x][y][val] = -1;
-                    changed++;
+            // Find the one cell in this unit that can take the value
+            int validPos = -1;
+            for(int i = 0; i < N; i++) {
+                if((CellCandidates(GRID<Box>.unitCells[unit][i]) >> val) & 1) {
+                    validPos = i;
+                    break;
                 }
             }
+            if(validPos == -1) continue;
+
+            int cell = GRID<Box>.unitCells[unit][validPos];
+            int row = cell / N, col = cell % N;
+            Trace(TRACE_PLACE, TECH_HIDDEN_SINGLES, cell, val, HIDDEN_SINGLE_REASONS[unit / N]);
+
+            SetValue(row, col, val);
+            if(!IsValidSolution()) {
+                print_debug("Invalid solution after setting %d at (%d,%d)\n", 
+                      val + 1, row + 1, col + 1);
+                return -1;
+            }
+            changed++;
         }
     }
+    
+    return changed;
+}
+
+// The unit of the given kind (0 or 1 for the lines, 2 for the box) that
+// holds every cell of unit picked out by positions, bit i for its i-th
+// cell; -1 if they lie in more than one
+template<int Box>
+static int SharedUnit(int unit, typename BasicSudoku<Box>::Mask positions, int kind) {
+    int shared = GRID<Box>.cellUnits[GRID<Box>.unitCells[unit][LowestBit(positions)]][kind];
+    for(; positions; positions &= positions - 1) {
+        if(GRID<Box>.cellUnits[GRID<Box>.unitCells[unit][LowestBit(positions)]][kind] != shared) return -1;
+    }
+    return shared;
 }
 
-int Sudoku::FindNakedSets() {
+template<int Box>
+int BasicSudoku<Box>::LinElim() {
     int changed = 0;
+    
+    // Helper to safely eliminate a candidate and track changes
+    auto eliminateCandidate = [this](int cell, int val, const char* reason) -> bool {
+        Mask mask = board.cells[cell];
+        // Don't touch solved cells or eliminate the last candidate
+        if(!((mask >> val) & 1) || !(mask & (mask - 1))) return false;
 
-    // Helper to get candidates for a cell
-    auto getCandidates = [this](int row, int col) -> std::vector<int> {
-        std::vector<int> candidates;
-        if(GetValue(row, col) == -1) {  // Only if cell is empty
-            for(int val = 0; val < 9; val++) {
-                if(board[row][col][val] == val && LegalValue(row, col, val)) {
-                    candidates.push_back(val);
-                }
-            }
+        EliminatePossibility(cell / N, cell % N, val);
+        Trace(TRACE_ELIMINATE, TECH_LINE_ELIM, cell, val, reason);
+        return true;
+    };
+
+    // A value with no place left in a unit, or more than fit in one line of a
+    // box, can't be placed or confined there. Counts only fall while we work,
+    // so a table refreshed after each change never skips a live pattern.
+    int counted = -1;
+    auto skipUnit = [this, &changed, &counted](int unit, int val) -> bool {
+        if(counted != changed) {
+            CountPlaces();
+            counted = changed;
         }
-        return candidates;
+        return places[unit][val] == 0 || places[unit][val] > Box;
     };
 
-    // Helper to check if candidates form a naked set
-    auto isNakedSet = [](const std::vector<std::vector<int>>& candidateSets, const std::vector<int>& unionCandidates) -> bool {
-        // All cells must contain only candidates from the union set
-        for(const auto& candidates : candidateSets) {
-            for(int val : candidates) {
-                if(std::find(unionCandidates.begin(), unionCandidates.end(), val) == unionCandidates.end()) {
-                    return false;
-                }
-            }
+    // Open cells of the unit that can take val, bit i for its i-th cell;
+    // none once the unit holds val
+    auto positions = [this](int unit, int val) -> Mask {
+        Mask found = 0;
+        if((board.used[unit] >> val) & 1) return found;
+        for(int i = 0; i < N; i++) {
+            if((CellCandidates(GRID<Box>.unitCells[unit][i]) >> val) & 1) found |= Mask(1) << i;
         }
-        return true;
+        return found;
     };
 
-    // Process each row
-    for(int row = 0; row < 9; row++) {
-        std::vector<std::pair<int, std::vector<int>>> cells;  // col, candidates
-        
-        // Collect empty cells and their candidates
-        for(int col = 0; col < 9; col++) {
-            auto candidates = getCandidates(row, col);
-            if(!candidates.empty()) {
-                cells.push_back({col, candidates});
-            }
+    // Remove val from the cells of unit outside keep, where it is confined
+    auto confine = [&](int unit, int keep, int val, const char* reason) {
+        for(int i = 0; i < N; i++) {
+            int cell = GRID<Box>.unitCells[unit][i];
+            if(!GRID<Box>.unitSets[keep].Has(cell) && eliminateCandidate(cell, val, reason)) changed++;
         }
+    };
 
-        // Try naked sets of size 2-4
-        for(int setSize = 2; setSize <= 4; setSize++) {
-            // Skip if we don't have enough cells
-            if(cells.size() < setSize) continue;
+    // Place val in the one cell of the unit left for it
+    auto placeSingle = [&](int unit, Mask found, int val, const char* reason) {
+        int cell = GRID<Box>.unitCells[unit][LowestBit(found)];
+        Trace(TRACE_PLACE, TECH_LINE_ELIM, cell, val, reason);
+        SetValue(cell / N, cell % N, val);
+        changed++;
+    };
 
-            // Try each combination of cells
-            std::vector<bool> selected(cells.size(), false);
-            for(int i = 0; i < setSize; i++) selected[cells.size() - 1 - i] = true;
+    // A row or column whose places for val lie in one box clears the rest of
+    // that box
+    auto checkLine = [&](int line, int val, const char* confined, const char* single) {
+        if(skipUnit(line, val)) return;
+        Mask found = positions(line, val);
+        if(BitCount(found) >= 2) {
+            int box = SharedUnit<Box>(line, found, 2);
+            if(box >= 0) confine(box, line, val, confined);
+        }
+        if(BitCount(found) == 1) placeSingle(line, found, val, single);
+    };
 
-            do {
-                std::vector<int> setCols;
-                std::vector<std::vector<int>> setCandidates;
-                std::set<int> uniqueCandidates;
+    // Process each value 1-N
+    for(int val = 0; val < N; val++) {
+        // Check boxes: places in one row or column clear the rest of it
+        for(int box = 2 * N; box < 3 * N; box++) {
+            if(skipUnit(box, val)) continue;
 
-                // Collect selected cells
-                for(size_t i = 0; i < cells.size(); i++) {
-                    if(selected[i]) {
-                        setCols.push_back(cells[i].first);
-                        setCandidates.push_back(cells[i].second);
-                        for(int val : cells[i].second) {
-                            uniqueCandidates.insert(val);
-                        }
-                    }
-                }
+            Mask found = positions(box, val);
+            if(BitCount(found) >= 2) {
+                int row = SharedUnit<Box>(box, found, 1);
+                if(row >= 0) confine(row, box, val, "value confined to box row");
+                int col = SharedUnit<Box>(box, found, 0);
+                if(col >= 0) confine(col, box, val, "value confined to box column");
+            }
 
-                // If number of unique candidates equals set size, we found a naked set
-                if(uniqueCandidates.size() == setSize) {
-                    std::vector<int> candidates(uniqueCandidates.begin(), uniqueCandidates.end());
-                    if(isNakedSet(setCandidates, candidates)) {
-                        // Eliminate these candidates from other cells in row
-                        bool madeChange = false;
-                        for(int col = 0; col < 9; col++) {
-                            if(std::find(setCols.begin(), setCols.end(), col) == setCols.end() && 
-                               GetValue(row, col) == -1) {
-                                for(int val : candidates) {
-                                    if(board[row][col][val] == val) {
-                                        board[row][col][val] = -1;
-                                        madeChange = true;
-                                    }
-                                }
-                            }
-                        }
-                        if(madeChange) changed++;
-                    }
-                }
-            } while(std::next_permutation(selected.begin(), selected.end()));
+            // Look for single candidate in box
+            if(BitCount(found) == 1) placeSingle(box, found, val, "only place in its box");
         }
-    }
 
-    // Process each column (similar logic)
-    for(int col = 0; col < 9; col++) {
-        std::vector<std::pair<int, std::vector<int>>> cells;  // row, candidates
-        
-        for(int row = 0; row < 9; row++) {
-            auto candidates = getCandidates(row, col);
-            if(!candidates.empty()) {
-                cells.push_back({row, candidates});
-            }
+        // Check rows, then columns
+        for(int row = N; row < 2 * N; row++) {
+            checkLine(row, val, "value confined to row in box", "only place in its row");
+        }
+        for(int col = 0; col < N; col++) {
+            checkLine(col, val, "value confined to column in box", "only place in its column");
         }
+    }
+    
+    if(!IsValidSolution()) {
+        print_debug("Invalid solution after line elimination\n");
+        return -1;
+    }
+    
+    return changed;
+}
 
-        for(int setSize = 2; setSize <= 4; setSize++) {
-            if(cells.size() < setSize) continue;
+template<int Box>
+typename BasicSudoku<Box>::Mask BasicSudoku<Box>::CellCandidates(int cell) {
+    if(MaskValue(board.cells[cell]) >= 0) return 0;
+    const auto* units = GRID<Box>.cellUnits[cell];
+    return board.cells[cell] & ~(board.used[units[0]] | board.used[units[1]] | board.used[units[2]]);
+}
 
-            std::vector<bool> selected(cells.size(), false);
-            for(int i = 0; i < setSize; i++) selected[cells.size() - 1 - i] = true;
+// Trace reason of a pointing pairs elimination, by the kind of line
+static const char* const POINTING_REASONS[2] = {
+    "box confines value to a row", "box confines value to a column"
+};
 
-            do {
-                std::vector<int> setRows;
-                std::vector<std::vector<int>> setCandidates;
-                std::set<int> uniqueCandidates;
+template<int Box>
+int BasicSudoku<Box>::FindPointingPairs() {
+    int changed = 0;
 
-                for(size_t i = 0; i < cells.size(); i++) {
-                    if(selected[i]) {
-                        setRows.push_back(cells[i].first);
-                        setCandidates.push_back(cells[i].second);
-                        for(int val : cells[i].second) {
-                            uniqueCandidates.insert(val);
-                        }
-                    }
-                }
+    // Helper to validate if elimination is safe
+    auto isSafeElimination = [this](int cell, int val) -> bool {
+        Mask mask = board.cells[cell];
+        // Don't touch solved cells or eliminate the last candidate
+        if(!((mask >> val) & 1) || !(mask & (mask - 1))) return false;
+
+        // If only one candidate would remain, it must not clash with a peer
+        int remaining = MaskValue(mask & ~(Mask(1) << val));
+        return remaining < 0 || LegalValue(cell / N, cell % N, remaining);
+    };
 
-                if(uniqueCandidates.size() == setSize) {
-                    std::vector<int> candidates(uniqueCandidates.begin(), uniqueCandidates.end());
-                    if(isNakedSet(setCandidates, candidates)) {
-                        bool madeChange = false;
-                        for(int row = 0; row < 9; row++) {
-                            if(std::find(setRows.begin(), setRows.end(), row) == setRows.end() && 
-                               GetValue(row, col) == -1) {
-                                for(int val : candidates) {
-                                    if(board[row][col][val] == val) {
-                                        board[row][col][val] = -1;
-                                        madeChange = true;
-                                    }
-                                }
-                            }
-                        }
-                        if(madeChange) changed++;
-                    }
-                }
-            } while(std::next_permutation(selected.begin(), selected.end()));
+    int counted = -1;
+
+    // For each box
+    for(int box = 2 * N; box < 3 * N; box++) {
+        // Eliminations lower the counts, refresh the table after each
+        if(counted != changed) {
+            CountPlaces();
+            counted = changed;
         }
-    }
 
-    // Process each 3x3 box
-    for(int boxRow = 0; boxRow < 3; boxRow++) {
-        for(int boxCol = 0; boxCol < 3; boxCol++) {
-            std::vector<std::pair<std::pair<int,int>, std::vector<int>>> cells;
-            
-            for(int i = 0; i < 3; i++) {
-                for(int j = 0; j < 3; j++) {
-                    int row = boxRow * 3 + i;
-                    int col = boxCol * 3 + j;
-                    auto candidates = getCandidates(row, col);
-                    if(!candidates.empty()) {
-                        cells.push_back({{row, col}, candidates});
-                    }
+        // For each possible value
+        for(int val = 0; val < N; val++) {
+            int count = places[box][val];
+            if(count < 2 || count > Box) continue;
+
+            // Find all positions where val is a candidate in this box, bit i
+            // for the box's i-th cell
+            Mask positions = 0;
+            for(int i = 0; i < N; i++) {
+                if((CellCandidates(GRID<Box>.unitCells[box][i]) >> val) & 1) {
+                    positions |= Mask(1) << i;
                 }
             }
 
-            for(int setSize = 2; setSize <= 4; setSize++) {
-                if(cells.size() < setSize) continue;
-
-                std::vector<bool> selected(cells.size(), false);
-                for(int i = 0; i < setSize; i++) selected[cells.size() - 1 - i] = true;
+            // Only proceed if we have 2 to Box positions
+            int found = BitCount(positions);
+            if(found < 2 || found > Box) continue;
 
-                do {
-                    std::vector<std::pair<int,int>> setPositions;
-                    std::vector<std::vector<int>> setCandidates;
-                    std::set<int> uniqueCandidates;
+            // Positions all in one row, then all in one column
+            int source = GRID<Box>.unitCells[box][LowestBit(positions)];
+            for(int kind = 0; kind < 2; kind++) {
+                int line = SharedUnit<Box>(box, positions, kind);
+                if(line < 0) continue;
 
-                    for(size_t i = 0; i < cells.size(); i++) {
-                        if(selected[i]) {
-                            setPositions.push_back(cells[i].first);
-                            setCandidates.push_back(cells[i].second);
-                            for(int val : cells[i].second) {
-                                uniqueCandidates.insert(val);
-                            }
-                        }
-                    }
+                // Before eliminating, verify the pattern is necessary
+                int candidatesInLine = 0;
+                for(int i = 0; i < N; i++) {
+                    Mask mask = board.cells[GRID<Box>.unitCells[line][i]];
+                    if(((mask >> val) & 1) && (mask & (mask - 1))) candidatesInLine++;
+                }
 
-                    if(uniqueCandidates.size() == setSize) {
-                        std::vector<int> candidates(uniqueCandidates.begin(), uniqueCandidates.end());
-                        if(isNakedSet(setCandidates, candidates)) {
-                            bool madeChange = false;
-                            for(int i = 0; i < 3; i++) {
-                                for(int j = 0; j < 3; j++) {
-                                    int row = boxRow * 3 + i;
-                                    int col = boxCol * 3 + j;
-                                    if(std::find(setPositions.begin(), setPositions.end(), 
-                                       std::make_pair(row,col)) == setPositions.end() && 
-                                       GetValue(row, col) == -1) {
-                                        for(int val : candidates) {
-                                            if(board[row][col][val] == val) {
-                                                board[row][col][val] = -1;
-                                                madeChange = true;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            if(madeChange) changed++;
-                        }
+                // Only proceed if there are more candidates outside the box
+                if(candidatesInLine <= found) continue;
+                bool madeChange = false;
+                for(int i = 0; i < N; i++) {
+                    int cell = GRID<Box>.unitCells[line][i];
+                    if(GRID<Box>.cellUnits[cell][2] != box && // Skip cells in our box
+                       isSafeElimination(cell, val)) {
+                        EliminatePossibility(cell / N, cell % N, val);
+                        Trace(TRACE_ELIMINATE, TECH_POINTING_PAIRS, cell, val, POINTING_REASONS[kind], source);
+                        madeChange = true;
                     }
-                } while(std::next_permutation(selected.begin(), selected.end()));
+                }
+                if(madeChange) changed++;
             }
         }
     }
+    
+    return changed;
+}
+
+// Index the open cells with exactly count candidates by their mask
+template<int Box, typename Groups>
+static void GroupCells(BasicSudoku<Box>& sudoku, int count, Groups& groups) {
+    for(int cell = 0; cell < BasicSudoku<Box>::CELLS; cell++) {
+        auto mask = sudoku.CellCandidates(cell);
+        if(BitCount(mask) == count) groups.Add(cell, mask);
+    }
+}
+
+// XY-Wing: a bivalue pivot {x,y} that sees two bivalue pincers {x,z} and
+// {y,z}. Whichever value the pivot takes, one pincer holds z, so z goes
+// from every cell that sees both pincers. The first pincer is a bivalue
+// peer of the pivot; the second is looked up in the bivalue index by its
+// mask and intersected with the pivot's peers.
+template<int Box>
+int BasicSudoku<Box>::FindXYWing() {
+    int changed = 0;
+    CellGroups<CELLS, Mask> bivalue;
+    GroupCells(*this, 2, bivalue);
+
+    ForEachCell<CELLS>({ &bivalue.all }, [&](int pivot) {
+        // Earlier eliminations may have solved cells since the index was built
+        Mask pivotCands = CellCandidates(pivot);
+        if(BitCount(pivotCands) != 2) return;
+        Mask x = pivotCands & (~pivotCands + 1), y = pivotCands & ~x;
+        const CellSet<CELLS>* sees = &GRID<Box>.sees[pivot];
+        ForEachCell<CELLS>({ &bivalue.all, sees }, [&](int wing1) {
+            Mask wing1Cands = CellCandidates(wing1);
+            if(BitCount(wing1Cands) != 2 || (wing1Cands & pivotCands) != x) return;
+            Mask zBit = wing1Cands & ~x;
+            int z = LowestBit(zBit);
+            const CellSet<CELLS>* yz = bivalue.Find(y | zBit);
+            if(!yz) return;
+
+            ForEachCell<CELLS>({ yz, sees }, [&](int wing2) {
+                bool madeChange = false;
+                ForEachCell<CELLS>({ &GRID<Box>.sees[wing1], &GRID<Box>.sees[wing2] }, [&](int cell) {
+                    Mask mask = board.cells[cell];
+                    if(!(mask & zBit) || !(mask & (mask - 1))) return;
+                    EliminatePossibility(cell / N, cell % N, z);
+                    madeChange = true;
+                    Trace(TRACE_ELIMINATE, TECH_XY_WING, cell, z, "sees both wings of pivot", pivot);
+                });
+                if(madeChange) changed++;
+            });
+        });
+    });
 
     return changed;
 }
 
-int Sudoku::FindPointingPairs() {
+// XYZ-Wing: a trivalue pivot {x,y,z} that sees two bivalue pincers {x,z}
+// and {y,z}. One of the three holds z, so z goes from every cell that sees
+// all three. Pincers are found as for the XY-Wing, the second taking the
+// larger mask so each pair is met once.
+template<int Box>
+int BasicSudoku<Box>::FindXYZWing() {
     int changed = 0;
+    CellGroups<CELLS, Mask> bivalue, trivalue;
+    GroupCells(*this, 2, bivalue);
+    GroupCells(*this, 3, trivalue);
+
+    ForEachCell<CELLS>({ &trivalue.all }, [&](int pivot) {
+        // Earlier eliminations may have solved cells since the index was built
+        Mask pivotCands = CellCandidates(pivot);
+        if(BitCount(pivotCands) != 3) return;
+        const CellSet<CELLS>* sees = &GRID<Box>.sees[pivot];
+        ForEachCell<CELLS>({ &bivalue.all, sees }, [&](int wing1) {
+            Mask wing1Cands = CellCandidates(wing1);
+            if(BitCount(wing1Cands) != 2 || (wing1Cands & ~pivotCands)) return;
+            for(Mask zs = wing1Cands; zs; zs &= zs - 1) {
+                Mask zBit = zs & (~zs + 1);
+                int z = LowestBit(zBit);
+                Mask wing2Cands = (pivotCands & ~wing1Cands) | zBit;
+                if(wing2Cands < wing1Cands) continue;
+                const CellSet<CELLS>* yz = bivalue.Find(wing2Cands);
+                if(!yz) continue;
+
+                ForEachCell<CELLS>({ yz, sees }, [&](int wing2) {
+                    Trace(TRACE_PATTERN, TECH_XYZ_WING, pivot, z, "pivot");
+                    bool madeChange = false;
+                    ForEachCell<CELLS>({ sees, &GRID<Box>.sees[wing1], &GRID<Box>.sees[wing2] }, [&](int cell) {
+                        Mask mask = board.cells[cell];
+                        if(!(mask & zBit) || !(mask & (mask - 1))) return;
+                        EliminatePossibility(cell / N, cell % N, z);
+                        madeChange = true;
+                        Trace(TRACE_ELIMINATE, TECH_XYZ_WING, cell, z, "sees pivot and both wings", pivot);
+                    });
+                    if(madeChange) changed++;
+                });
+            }
+        });
+    });
 
-    // Helper to validate if elimination is safe
-    auto isSafeElimination = [this](int row, int col, int val) -> bool {
-        // Don't eliminate if cell is already solved
-        if(GetValue(row, col) != -1) return false;
-        
-        // Don't eliminate if value isn't a candidate
-        if(board[row][col][val] != val) return false;
-        
-        // Count remaining candidates before elimination
-        int candidateCount = 0;
-        for(int v = 0; v < 9; v++) {
-            if(board[row][col][v] == v) candidateCount++;
-        }
-        
-        // Don't eliminate if it's the last candidate
-        if(candidateCount <= 1) return false;
+    return changed;
+}
 
-        // Temporarily eliminate and check validity
-        board[row][col][val] = -1;
-        bool valid = IsValidSolution();
-        board[row][col][val] = val;  // Restore
-        
-        return valid;
+// Simple coloring on each value. Two cells are conjugate when they are the
+// only places left for the value in some unit, so exactly one of them holds
+// it. Coloring a chain of conjugate pairs in alternating colors splits it
+// into two groups, one of which holds the value everywhere. If two cells of
+// one color see each other that color is false; a cell outside the chain
+// that sees both colors can't hold the value either way.
+template<int Box>
+int BasicSudoku<Box>::FindSimpleColoring() {
+    int changed = 0;
+
+    // Remove val from an open cell, counting it in madeChange
+    auto eliminate = [this](int cell, int val, bool& madeChange) {
+        Mask mask = board.cells[cell];
+        if(((mask >> val) & 1) && (mask & (mask - 1))) {
+            EliminatePossibility(cell / N, cell % N, val);
+            madeChange = true;
+        }
     };
 
-    // For each 3x3 box
-    for(int boxRow = 0; boxRow < 3; boxRow++) {
-        for(int boxCol = 0; boxCol < 3; boxCol++) {
-            // For each possible value
-            for(int val = 0; val < 9; val++) {
-                std::vector<std::pair<int, int>> positions;
-                
-                // Find all positions where val is a candidate in this box
-                for(int i = 0; i < 3; i++) {
-                    for(int j = 0; j < 3; j++) {
-                        int row = boxRow * 3 + i;
-                        int col = boxCol * 3 + j;
-                        if(GetValue(row, col) == -1 && board[row][col][val] == val) {
-                            positions.push_back({row, col});
-                        }
-                    }
-                }
+    for(int val = 0; val < N; val++) {
+        bool candidate[CELLS];
+        for(int cell = 0; cell < CELLS; cell++) {
+            candidate[cell] = (CellCandidates(cell) >> val) & 1;
+        }
 
-                // Only proceed if we have 2 or 3 positions
-                if(positions.size() >= 2 && positions.size() <= 3) {
-                    // Check if all positions are in the same row
-                    bool sameRow = true;
-                    int firstRow = positions[0].first;
-                    for(const auto& pos : positions) {
-                        if(pos.first != firstRow) {
-                            sameRow = false;
-                            break;
-                        }
-                    }
+        // Strong links from every unit with exactly two places for the value.
+        // Places only shrink as we eliminate, so the links stay strong.
+        int links[CELLS][3];
+        int linkCount[CELLS] = {};
+        for(int unit = 0; unit < UNITS; unit++) {
+            int ends[2];
+            int found = 0;
+            for(int i = 0; i < N && found <= 2; i++) {
+                int cell = GRID<Box>.unitCells[unit][i];
+                if(candidate[cell]) {
+                    if(found < 2) ends[found] = cell;
+                    found++;
+                }
+            }
+            if(found != 2) continue;
 
-                    if(sameRow) {
-                        // Before eliminating, verify the pattern is necessary
-                        int candidatesInRow = 0;
-                        for(int col = 0; col < 9; col++) {
-                            if(GetValue(firstRow, col) == -1 && board[firstRow][col][val] == val) {
-                                candidatesInRow++;
-                            }
-                        }
-                        
-                        // Only proceed if there are more candidates outside the box
-                        if(candidatesInRow > positions.size()) {
-                            bool madeChange = false;
-                            // Eliminate val from other cells in this row
-                            for(int col = 0; col < 9; col++) {
-                                if(col / 3 != boxCol && // Skip cells in our box
-                                   isSafeElimination(firstRow, col, val)) {
-                                    board[firstRow][col][val] = -1;
-                                    madeChange = true;
-                                }
-                            }
-                            if(madeChange) changed++;
-                        }
-                    }
+            // A pair sharing a line and a box is linked by both units
+            bool known = false;
+            for(int k = 0; k < linkCount[ends[0]]; k++) {
+                if(links[ends[0]][k] == ends[1]) known = true;
+            }
+            if(known) continue;
+            links[ends[0]][linkCount[ends[0]]++] = ends[1];
+            links[ends[1]][linkCount[ends[1]]++] = ends[0];
+        }
 
-                    // Check if all positions are in the same column
-                    bool sameCol = true;
-                    int firstCol = positions[0].second;
-                    for(const auto& pos : positions) {
-                        if(pos.second != firstCol) {
-                            sameCol = false;
-                            break;
-                        }
+        // Color each chain breadth first; chain lists its cells in order
+        signed char color[CELLS];
+        int chainOf[CELLS];
+        for(int cell = 0; cell < CELLS; cell++) {
+            color[cell] = -1;
+            chainOf[cell] = -1;
+        }
+        int chain[CELLS];
+        for(int root = 0; root < CELLS; root++) {
+            if(!linkCount[root] || color[root] >= 0) continue;
+
+            int length = 0;
+            chain[length++] = root;
+            color[root] = 0;
+            chainOf[root] = root;
+            for(int head = 0; head < length; head++) {
+                int cell = chain[head];
+                for(int k = 0; k < linkCount[cell]; k++) {
+                    int next = links[cell][k];
+                    if(color[next] < 0) {
+                        color[next] = 1 - color[cell];
+                        chainOf[next] = root;
+                        chain[length++] = next;
                     }
+                }
+            }
 
-                    if(sameCol) {
-                        // Before eliminating, verify the pattern is necessary
-                        int candidatesInCol = 0;
-                        for(int row = 0; row < 9; row++) {
-                            if(GetValue(row, firstCol) == -1 && board[row][firstCol][val] == val) {
-                                candidatesInCol++;
-                            }
-                        }
-                        
-                        // Only proceed if there are more candidates outside the box
-                        if(candidatesInCol > positions.size()) {
-                            bool madeChange = false;
-                            // Eliminate val from other cells in this column
-                            for(int row = 0; row < 9; row++) {
-                                if(row / 3 != boxRow && // Skip cells in our box
-                                   isSafeElimination(row, firstCol, val)) {
-                                    board[row][firstCol][val] = -1;
-                                    madeChange = true;
-                                }
-                            }
-                            if(madeChange) changed++;
-                        }
+            // Color wrap: two cells of one color in a unit make that color false
+            int falseColor = -1;
+            int clash[2] = {};
+            for(int i = 0; i < length && falseColor < 0; i++) {
+                for(int j = i + 1; j < length; j++) {
+                    if(color[chain[i]] == color[chain[j]] && Sees<Box>(chain[i], chain[j])) {
+                        falseColor = color[chain[i]];
+                        clash[0] = chain[i];
+                        clash[1] = chain[j];
+                        break;
                     }
                 }
             }
-        }
-    }
-    
-    return changed;
-}
-
-int Sudoku::FindXYWing() {
-    // Helper to get candidates for a cell
-    auto getCandidates = [this](int row, int col) -> std::vector<int> {
-        std::vector<int> candidates;
-        if(GetValue(row, col) == -1) {
-            for(int val = 0; val < 9; val++) {
-                if(board[row][col][val] == val) {
-                    candidates.push_back(val);
+            if(falseColor >= 0) {
+                bool madeChange = false;
+                for(int i = 0; i < length; i++) {
+                    if(color[chain[i]] == falseColor) eliminate(chain[i], val, madeChange);
+                }
+                if(madeChange) {
+                    changed++;
+                    Trace(TRACE_PATTERN, TECH_SIMPLE_COLORING, clash[0], val,
+                          "color wrap, that color eliminated", clash[1]);
                 }
+                continue;
             }
-        }
-        return candidates;
-    };
-
-    // Helper to check if cells share a unit
-    auto shareUnit = [](int row1, int col1, int row2, int col2) -> bool {
-        return row1 == row2 ||  // Same row
-               col1 == col2 ||  // Same column
-               (row1/3 == row2/3 && col1/3 == col2/3);  // Same box
-    };
 
-    // Store board state before any changes
-    int originalBoard[9][9][9];
-    memcpy(originalBoard, board, sizeof(board));
+            // Color trap: cells off the chain that see both colors
+            for(int cell = 0; cell < CELLS; cell++) {
+                if(!candidate[cell] || chainOf[cell] == root) continue;
+                bool seen[2] = {};
+                for(int i = 0; i < length && !(seen[0] && seen[1]); i++) {
+                    if(Sees<Box>(cell, chain[i])) seen[color[chain[i]]] = true;
+                }
+                if(!seen[0] || !seen[1]) continue;
 
-    struct Elimination {
-        int row, col, val;
-        Elimination(int r, int c, int v) : row(r), col(c), val(v) {}
-    };
-    std::vector<Elimination> potentialEliminations;
-
-    // Find all potential eliminations first
-    for(int pivotRow = 0; pivotRow < 9; pivotRow++) {
-        for(int pivotCol = 0; pivotCol < 9; pivotCol++) {
-            auto pivotCands = getCandidates(pivotRow, pivotCol);
-            if(pivotCands.size() != 2) continue;
-
-            for(int wing1Row = 0; wing1Row < 9; wing1Row++) {
-                for(int wing1Col = 0; wing1Col < 9; wing1Col++) {
-                    if(wing1Row == pivotRow && wing1Col == pivotCol) continue;
-                    if(!shareUnit(pivotRow, pivotCol, wing1Row, wing1Col)) continue;
-
-                    auto wing1Cands = getCandidates(wing1Row, wing1Col);
-                    if(wing1Cands.size() != 2) continue;
-
-                    // Find shared candidate between pivot and wing1
-                    int sharedWithWing1 = -1;
-                    for(int val : pivotCands) {
-                        if(std::find(wing1Cands.begin(), wing1Cands.end(), val) != wing1Cands.end()) {
-                            sharedWithWing1 = val;
-                            break;
-                        }
-                    }
-                    if(sharedWithWing1 == -1) continue;
-
-                    for(int wing2Row = 0; wing2Row < 9; wing2Row++) {
-                        for(int wing2Col = 0; wing2Col < 9; wing2Col++) {
-                            if((wing2Row == pivotRow && wing2Col == pivotCol) ||
-                               (wing2Row == wing1Row && wing2Col == wing1Col)) continue;
-                            if(!shareUnit(pivotRow, pivotCol, wing2Row, wing2Col)) continue;
-
-                            auto wing2Cands = getCandidates(wing2Row, wing2Col);
-                            if(wing2Cands.size() != 2) continue;
-
-                            // Find shared candidate between pivot and wing2
-                            int sharedWithWing2 = -1;
-                            for(int val : pivotCands) {
-                                if(val != sharedWithWing1 &&
-                                   std::find(wing2Cands.begin(), wing2Cands.end(), val) != wing2Cands.end()) {
-                                    sharedWithWing2 = val;
-                                    break;
-                                }
-                            }
-                            if(sharedWithWing2 == -1) continue;
-
-                            // Find common candidate between wings
-                            int commonWingVal = -1;
-                            for(int val : wing1Cands) {
-                                if(val != sharedWithWing1 &&
-                                   std::find(wing2Cands.begin(), wing2Cands.end(), val) != wing2Cands.end()) {
-                                    commonWingVal = val;
-                                    break;
-                                }
-                            }
-                            if(commonWingVal == -1) continue;
-
-                            // Store potential eliminations
-                            for(int row = 0; row < 9; row++) {
-                                for(int col = 0; col < 9; col++) {
-                                    if((row == pivotRow && col == pivotCol) ||
-                                       (row == wing1Row && col == wing1Col) ||
-                                       (row == wing2Row && col == wing2Col)) continue;
-
-                                    if(shareUnit(row, col, wing1Row, wing1Col) &&
-                                       shareUnit(row, col, wing2Row, wing2Col) &&
-                                       GetValue(row, col) == -1 &&
-                                       board[row][col][commonWingVal] == commonWingVal) {
-                                        potentialEliminations.push_back(Elimination(row, col, commonWingVal));
-                                    }
-                                }
-                            }
-                        }
-                    }
+                bool madeChange = false;
+                eliminate(cell, val, madeChange);
+                if(madeChange) {
+                    changed++;
+                    Trace(TRACE_ELIMINATE, TECH_SIMPLE_COLORING, cell, val, "sees both colors");
                 }
             }
         }
     }
 
-    // Try each elimination one at a time
-    for(const auto& elim : potentialEliminations) {
-        // Restore original board state
-        memcpy(board, originalBoard, sizeof(board));
+    return changed;
+}
 
-        // Try this single elimination
-        print_debug("Trying to eliminate %d from (%d,%d)\n", 
-                   elim.val + 1, elim.row + 1, elim.col + 1);
+// Alternating inference chains. Every open candidate is a node. A strong
+// link joins two nodes of which at least one is true: the two candidates of
+// a bivalue cell, or the two places left for a value in a unit. A weak link
+// joins two of which at most one is: candidates sharing a cell, or the same
+// value in cells that see each other. Assuming a start candidate false and
+// following strong then weak links in turn proves further candidates true;
+// the start and any of those can't both be false, so a candidate weakly
+// linked to both is eliminated. A chain that proves its own start true
+// places it. XY-chains and X-chains are the chains of one link type.
+//
+// The strong links are indexed once per pass. The search from each start is
+// breadth first and reaches each node at most once as true and once as
+// false, so the chains it finds are the shortest, up to MAX_CHAIN links.
+template<int Box>
+struct ChainIndex
+{
+  static const int NODES = Box * Box * Box * Box * Box * Box;
+
+  // At most four strong links per node: its cell and its three units
+  unsigned short strong[NODES * 4];
+  unsigned char strongCount[NODES];
+
+  // Search state node * 2 + 1 proves node true, node * 2 false. reached[]
+  // holds the start that last reached a state, so nothing is cleared
+  // between starts.
+  unsigned short reached[NODES * 2];
+  unsigned short parent[NODES * 2];
+  unsigned char length[NODES * 2];
+  unsigned short queue[NODES * 2];
+};
+
+template<int Box>
+int BasicSudoku<Box>::FindChains() {
+    const int NODES = CELLS * N;
+    const int MAX_CHAIN = 16;
+    const unsigned short NONE = 0xffff;
+    static_assert(2 * NODES < NONE, "search states must fit in 16 bits");
+    int changed = 0;
+    ChainIndex<Box>& index = chainIndex.Get();
 
-        board[elim.row][elim.col][elim.val] = -1;
+    // Node cell * N + val is the candidate val of cell
+    Mask candidates[CELLS];
+    for(int cell = 0; cell < CELLS; cell++) {
+        candidates[cell] = CellCandidates(cell);
+    }
 
-        // Validate the change
-        if(IsValidSolution()) {
-            print_debug("Successfully eliminated %d from (%d,%d)\n", 
-                       elim.val + 1, elim.row + 1, elim.col + 1);
-            return 1; // Return after one successful change
+    unsigned short* strong = index.strong;
+    unsigned char* strongCount = index.strongCount;
+    std::fill(strongCount, strongCount + NODES, 0);
+    auto link = [&](int a, int b) {
+        for(int k = 0; k < strongCount[a]; k++) {
+            if(strong[a * 4 + k] == b) return;
+        }
+        strong[a * 4 + strongCount[a]++] = b;
+        strong[b * 4 + strongCount[b]++] = a;
+    };
+    for(int cell = 0; cell < CELLS; cell++) {
+        Mask mask = candidates[cell];
+        if(BitCount(mask) == 2) {
+            link(cell * N + LowestBit(mask), cell * N + LowestBit(mask & (mask - 1)));
         }
-
-        // If invalid, next iteration will restore original state
     }
-
-    // No valid eliminations found
-    memcpy(board, originalBoard, sizeof(board));
-    return 0;
-}
-
-int Sudoku::FindXYZWing() {
-    int changed = 0;
-
-    // Helper to get candidates for a cell
-    auto getCandidates = [this](int row, int col) -> std::vector<int> {
-        std::vector<int> candidates;
-        if(GetValue(row, col) == -1) {
-            for(int val = 0; val < 9; val++) {
-                if(board[row][col][val] == val) {
-                    candidates.push_back(val);
-                }
+    for(int unit = 0; unit < UNITS; unit++) {
+        int places[N] = {};
+        int ends[N][2];
+        for(int i = 0; i < N; i++) {
+            int cell = GRID<Box>.unitCells[unit][i];
+            for(Mask rest = candidates[cell]; rest; rest &= rest - 1) {
+                int val = LowestBit(rest);
+                if(places[val] < 2) ends[val][places[val]] = cell;
+                places[val]++;
             }
         }
-        return candidates;
+        for(int val = 0; val < N; val++) {
+            if(places[val] == 2) link(ends[val][0] * N + val, ends[val][1] * N + val);
+        }
+    }
+
+    // Call visit on every node weakly linked to node
+    auto weakLinks = [&](int node, auto&& visit) {
+        int cell = node / N, val = node % N;
+        for(Mask rest = candidates[cell] & ~(Mask(1) << val); rest; rest &= rest - 1) {
+            visit(cell * N + LowestBit(rest));
+        }
+        for(int k = 0; k < GridTables<Box>::PEERS; k++) {
+            int peer = GRID<Box>.peers[cell][k];
+            if((candidates[peer] >> val) & 1) visit(peer * N + val);
+        }
     };
 
-    // Helper to check if cells can see each other
-    auto canSee = [](int row1, int col1, int row2, int col2) -> bool {
-        return row1 == row2 ||  // Same row
-               col1 == col2 ||  // Same column
-               (row1/3 == row2/3 && col1/3 == col2/3);  // Same box
+    // Remove a candidate still open on the board
+    auto eliminate = [this](int node) {
+        Mask mask = board.cells[node / N];
+        if(!((mask >> (node % N)) & 1) || !(mask & (mask - 1))) return false;
+        EliminatePossibility(node / N / N, node / N % N, node % N);
+        return true;
     };
 
-    // Helper to validate elimination
-    auto isSafeElimination = [this](int row, int col, int val) -> bool {
-        if(GetValue(row, col) != -1) return false;
-        if(board[row][col][val] != val) return false;
-        
-        int candidateCount = 0;
-        for(int v = 0; v < 9; v++) {
-            if(board[row][col][v] == v) candidateCount++;
+    unsigned short* reached = index.reached;
+    unsigned short* parent = index.parent;
+    unsigned char* length = index.length;
+    unsigned short* queue = index.queue;
+    std::fill(reached, reached + NODES * 2, NONE);
+
+    // Trace the chain ending at state, start first
+    int chain[MAX_CHAIN + 1];
+    auto traceChain = [&](int state) {
+        int count = 0;
+        for(; state != NONE; state = parent[state]) chain[count++] = state;
+        while(count-- > 0) {
+            int node = chain[count] >> 1;
+            int from = parent[chain[count]];
+            Trace(TRACE_PATTERN, TECH_CHAINS, node / N, node % N,
+                  (chain[count] & 1) ? "chain, true" : "chain, false", from != NONE ? (from >> 1) / N : -1);
         }
-        return candidateCount > 1;
     };
 
-    // For each potential pivot cell (must have exactly 3 candidates)
-    for(int pivotRow = 0; pivotRow < 9; pivotRow++) {
-        for(int pivotCol = 0; pivotCol < 9; pivotCol++) {
-            auto pivotCands = getCandidates(pivotRow, pivotCol);
-            if(pivotCands.size() != 3) continue;  // Must have exactly 3 candidates
-
-            // For each potential first wing
-            for(int wing1Row = 0; wing1Row < 9; wing1Row++) {
-                for(int wing1Col = 0; wing1Col < 9; wing1Col++) {
-                    if(wing1Row == pivotRow && wing1Col == pivotCol) continue;
-                    if(!canSee(pivotRow, pivotCol, wing1Row, wing1Col)) continue;
-
-                    auto wing1Cands = getCandidates(wing1Row, wing1Col);
-                    if(wing1Cands.size() != 2) continue;  // Must have exactly 2 candidates
-
-                    // Verify wing1 shares exactly 2 candidates with pivot
-                    std::vector<int> sharedWithWing1;
-                    for(int val : wing1Cands) {
-                        if(std::find(pivotCands.begin(), pivotCands.end(), val) != pivotCands.end()) {
-                            sharedWithWing1.push_back(val);
-                        }
-                    }
-                    if(sharedWithWing1.size() != 2) continue;
-
-                    // For each potential second wing
-                    for(int wing2Row = 0; wing2Row < 9; wing2Row++) {
-                        for(int wing2Col = 0; wing2Col < 9; wing2Col++) {
-                            if((wing2Row == pivotRow && wing2Col == pivotCol) ||
-                               (wing2Row == wing1Row && wing2Col == wing1Col)) continue;
-                            if(!canSee(pivotRow, pivotCol, wing2Row, wing2Col)) continue;
-
-                            auto wing2Cands = getCandidates(wing2Row, wing2Col);
-                            if(wing2Cands.size() != 2) continue;
-
-                            // Verify wing2 shares exactly 2 candidates with pivot
-                            std::vector<int> sharedWithWing2;
-                            for(int val : wing2Cands) {
-                                if(std::find(pivotCands.begin(), pivotCands.end(), val) != pivotCands.end()) {
-                                    sharedWithWing2.push_back(val);
-                                }
-                            }
-                            if(sharedWithWing2.size() != 2) continue;
-
-                            // Find the common candidate Z (present in all three cells)
-                            int Z = -1;
-                            for(int val : pivotCands) {
-                                if(std::find(wing1Cands.begin(), wing1Cands.end(), val) != wing1Cands.end() &&
-                                   std::find(wing2Cands.begin(), wing2Cands.end(), val) != wing2Cands.end()) {
-                                    Z = val;
-                                    break;
-                                }
-                            }
-                            if(Z == -1) continue;
-
-                            // Found XYZ-Wing pattern! Look for cells that see all three cells
-                            print_debug("Found XYZ-Wing: pivot(%d,%d) wings(%d,%d)(%d,%d) Z=%d\n",
-                                      pivotRow + 1, pivotCol + 1, 
-                                      wing1Row + 1, wing1Col + 1,
-                                      wing2Row + 1, wing2Col + 1,
-                                      Z + 1);
-
-                            bool madeChange = false;
-                            for(int row = 0; row < 9; row++) {
-                                for(int col = 0; col < 9; col++) {
-                                    // Skip the cells in the pattern
-                                    if((row == pivotRow && col == pivotCol) ||
-                                       (row == wing1Row && col == wing1Col) ||
-                                       (row == wing2Row && col == wing2Col)) continue;
-
-                                    // Must see all three cells
-                                    if(canSee(row, col, pivotRow, pivotCol) &&
-                                       canSee(row, col, wing1Row, wing1Col) &&
-                                       canSee(row, col, wing2Row, wing2Col) &&
-                                       isSafeElimination(row, col, Z)) {
-                                        
-                                        board[row][col][Z] = -1;
-                                        madeChange = true;
-                                        print_debug("Eliminated %d from (%d,%d)\n", 
-                                                  Z + 1, row + 1, col + 1);
-                                    }
-                                }
-                            }
-
-                            if(madeChange) {
-                                changed++;
-                                // Validate after changes
-                                if(!IsValidSolution()) {
-                                    print_debug("Invalid solution after XYZ-Wing elimination\n");
-                                    return -1;
-                                }
-                            }
-                        }
-                    }
+    for(int start = 0; start < NODES; start++) {
+        if(!strongCount[start] || !((board.cells[start / N] >> (start % N)) & 1)) continue;
+
+        int head = 0, tail = 0;
+        queue[tail++] = start * 2;
+        reached[start * 2] = start;
+        parent[start * 2] = NONE;
+        length[start * 2] = 0;
+        auto reach = [&](int state, int from) {
+            if(reached[state] == start) return;
+            reached[state] = start;
+            parent[state] = from;
+            length[state] = length[from] + 1;
+            queue[tail++] = state;
+        };
+        while(head < tail) {
+            int state = queue[head++];
+            if(length[state] == MAX_CHAIN) continue;
+            int node = state >> 1;
+            if(state & 1) {
+                weakLinks(node, [&](int next) { reach(next * 2, state); });
+            } else {
+                for(int k = 0; k < strongCount[node]; k++) {
+                    reach(strong[node * 4 + k] * 2 + 1, state);
+                }
+            }
+        }
+
+        // The chain came back round: the start can't be false
+        if(reached[start * 2 + 1] == start) {
+            int cell = start / N;
+            traceChain(start * 2 + 1);
+            bool madeChange = false;
+            for(Mask rest = candidates[cell] & ~(Mask(1) << (start % N)); rest; rest &= rest - 1) {
+                int node = cell * N + LowestBit(rest);
+                if(eliminate(node)) {
+                    madeChange = true;
+                    Trace(TRACE_ELIMINATE, TECH_CHAINS, cell, node % N, "chain proves another value", cell);
                 }
             }
+            if(madeChange) changed++;
+            continue;
         }
+
+        // Candidates weakly linked to the start and to a node it proves true
+        weakLinks(start, [&](int victim) {
+            if(!((board.cells[victim / N] >> (victim % N)) & 1)) return;
+            int end = -1;
+            weakLinks(victim, [&](int node) {
+                if(end < 0 && node != start && reached[node * 2 + 1] == start) end = node;
+            });
+            if(end >= 0 && eliminate(victim)) {
+                changed++;
+                traceChain(end * 2 + 1);
+                Trace(TRACE_ELIMINATE, TECH_CHAINS, victim / N, victim % N,
+                      "sees both ends of a chain", start / N);
+            }
+        });
     }
-    
+
     return changed;
 }
 
-int Sudoku::FindSimpleColoring() {
-    int changed = 0;
-    
-    // Helper to get candidates for a cell
-    auto getCandidates = [this](int row, int col) -> std::vector<int> {
-        std::vector<int> candidates;
-        if(GetValue(row, col) != -1) return candidates;
-        for(int val = 0; val < 9; val++) {
-            if(board[row][col][val] == val && LegalValue(row, col, val)) {
-                candidates.push_back(val);
-            }
+// Almost locked set: n open cells of one unit with n + 1 candidates between
+// them. If any one of those values is ruled out the rest are locked into
+// the cells.
+template<int Box>
+struct AlmostLockedSet
+{
+  static const int MAX_CELLS = 5;
+  typedef typename BasicSudoku<Box>::Mask Mask;
+
+  int size;
+  typename GridTables<Box>::Index cells[MAX_CELLS];
+  Mask cands[MAX_CELLS];
+  Mask values;
+  short slot[Box * Box];    // entry of each value in the index's places and seesAll
+  CellSet<Box * Box * Box * Box> members;
+};
+
+// The sets found on a pass, in fixed storage. places and seesAll hold, for
+// each value of each set in turn, the cells of the set that can take it and
+// the cells that see all of those. For the ALS-XY-Wing, pairs lists each
+// pair of sets with restricted common values once, and entries offsets[i]
+// to offsets[i + 1] of linked and common the sets linked to set i and those
+// values. Sets or pairs past the capacity are dropped, which only loses
+// patterns.
+template<int Box>
+struct AlmostLockedSetIndex
+{
+  static const int CELLS = Box * Box * Box * Box;
+  static const int MAX_SETS = 1024;
+  static const int MAX_VALUES = 4 * MAX_SETS;
+  static const int MAX_PAIRS = 8192;
+  typedef typename BasicSudoku<Box>::Mask Mask;
+
+  int count;
+  int valueCount;
+  AlmostLockedSet<Box> sets[MAX_SETS];
+  CellSet<CELLS> places[MAX_VALUES];
+  CellSet<CELLS> seesAll[MAX_VALUES];
+
+  int pairCount;
+  unsigned short pairs[MAX_PAIRS][2];
+  Mask pairCommon[MAX_PAIRS];
+  int offsets[MAX_SETS + 1];
+  unsigned short linked[2 * MAX_PAIRS];
+  Mask common[2 * MAX_PAIRS];
+
+  const CellSet<CELLS>& Places(const AlmostLockedSet<Box>& set, int val) const { return places[set.slot[val]]; }
+  const CellSet<CELLS>& SeesAll(const AlmostLockedSet<Box>& set, int val) const { return seesAll[set.slot[val]]; }
+};
+
+// Extend the set in als by each open cell of the unit from position next on
+template<int Box>
+static void CollectAlmostLockedSets(int unit, const typename BasicSudoku<Box>::Mask (&cands)[Box * Box],
+                                    int next, AlmostLockedSet<Box>& als,
+                                    AlmostLockedSetIndex<Box>& index)
+{
+  const int N = Box * Box;
+  typedef typename BasicSudoku<Box>::Mask Mask;
+  for(int pos = next; pos < N; pos++)
+  {
+    Mask values = als.values | cands[pos];
+    if(!cands[pos] || BitCount(values) > AlmostLockedSet<Box>::MAX_CELLS + 1) continue;
+
+    Mask previous = als.values;
+    als.cells[als.size] = GRID<Box>.unitCells[unit][pos];
+    als.cands[als.size++] = cands[pos];
+    als.values = values;
+
+    // List each set from the first unit holding all its cells
+    bool first = true;
+    for(int k = 0; k < 3 && first; k++)
+    {
+      int other = GRID<Box>.cellUnits[als.cells[0]][k];
+      bool holds = other < unit;
+      for(int i = 1; i < als.size && holds; i++)
+      {
+        const auto* units = GRID<Box>.cellUnits[als.cells[i]];
+        holds = units[0] == other || units[1] == other || units[2] == other;
+      }
+      if(holds) first = false;
+    }
+
+    if(first && BitCount(values) == als.size + 1 && index.count < AlmostLockedSetIndex<Box>::MAX_SETS &&
+       index.valueCount + als.size + 1 <= AlmostLockedSetIndex<Box>::MAX_VALUES)
+    {
+      AlmostLockedSet<Box>& found = index.sets[index.count++];
+      found = als;
+      found.members = CellSet<N * N>();
+      for(int i = 0; i < als.size; i++) found.members.Add(als.cells[i]);
+      for(Mask rest = values; rest; rest &= rest - 1)
+      {
+        int val = LowestBit(rest);
+        found.slot[val] = index.valueCount;
+        CellSet<N * N>& places = index.places[index.valueCount];
+        CellSet<N * N>& seen = index.seesAll[index.valueCount++];
+        places = CellSet<N * N>();
+        for(int w = 0; w < CellSet<N * N>::WORDS; w++) seen.words[w] = ~0ULL;
+        for(int i = 0; i < als.size; i++)
+        {
+          if(!((als.cands[i] >> val) & 1)) continue;
+          places.Add(als.cells[i]);
+          for(int w = 0; w < CellSet<N * N>::WORDS; w++) seen.words[w] &= GRID<Box>.sees[als.cells[i]].words[w];
         }
-        return candidates;
-    };
+      }
+    }
+    if(als.size < AlmostLockedSet<Box>::MAX_CELLS)
+    {
+      CollectAlmostLockedSets<Box>(unit, cands, pos + 1, als, index);
+    }
 
-    // Helper to check if cells can see each other (same row, column, or box)
-    auto canSee = [](int row1, int col1, int row2, int col2) -> bool {
-        return row1 == row2 ||  // Same row
-               col1 == col2 ||  // Same column
-               (row1/3 == row2/3 && col1/3 == col2/3);  // Same box
-    };
+    als.size--;
+    als.values = previous;
+  }
+}
+
+// Index of every almost locked set of up to MAX_CELLS cells, each listed once
+template<int Box>
+static void FindAlmostLockedSets(BasicSudoku<Box>& sudoku, AlmostLockedSetIndex<Box>& index)
+{
+  const int N = Box * Box;
+  index.count = 0;
+  index.valueCount = 0;
+  for(int unit = 0; unit < 3 * N; unit++)
+  {
+    typename BasicSudoku<Box>::Mask cands[N];
+    for(int i = 0; i < N; i++)
+    {
+      cands[i] = sudoku.CellCandidates(GRID<Box>.unitCells[unit][i]);
+    }
+    AlmostLockedSet<Box> als;
+    als.size = 0;
+    als.values = 0;
+    CollectAlmostLockedSets<Box>(unit, cands, 0, als, index);
+  }
+}
+
+// Values that are restricted common candidates of two disjoint sets: every
+// cell of one that can take the value sees every such cell of the other,
+// so at most one of the sets holds it
+template<int Box>
+static typename BasicSudoku<Box>::Mask RestrictedCommon(const AlmostLockedSetIndex<Box>& index,
+                                                        const AlmostLockedSet<Box>& a, const AlmostLockedSet<Box>& b)
+{
+  typedef typename BasicSudoku<Box>::Mask Mask;
+  const int WORDS = CellSet<Box * Box * Box * Box>::WORDS;
+  Mask shared = a.values & b.values;
+  if(!shared) return 0;
+  for(int w = 0; w < WORDS; w++)
+  {
+    if(a.members.words[w] & b.members.words[w]) return 0;
+  }
+  Mask common = 0;
+  for(Mask rest = shared; rest; rest &= rest - 1)
+  {
+    int val = LowestBit(rest);
+    const auto& places = index.Places(b, val);
+    const auto& seen = index.SeesAll(a, val);
+    unsigned long long unseen = 0;
+    for(int w = 0; w < WORDS; w++) unseen |= places.words[w] & ~seen.words[w];
+    if(!unseen) common |= Mask(1) << val;
+  }
+  return common;
+}
 
-    // Structure to represent a cell in the coloring chain
-    struct ColoredCell {
-        int row, col;
-        bool color;  // true for color1, false for color2
-        ColoredCell(int r, int c, bool clr) : row(r), col(c), color(clr) {}
+// Almost locked set rules, ALS-XZ or ALS-XY-Wing, over the index of the
+// sets found on this pass.
+//
+// ALS-XZ: two disjoint sets with a restricted common value x. Only one can
+// hold x, so the other is locked without it: every other value z they share
+// is placed in one set or the other, and leaves each cell that sees all of
+// z's places in both.
+//
+// ALS-XY-Wing: a pivot set with restricted common values x shared with set
+// A and y shared with set B. The pivot can't lose both x and y, so A or B is
+// locked and any value z they share, other than x and y, is placed in one
+// of them.
+template<int Box>
+int BasicSudoku<Box>::FindAls(bool wing) {
+    SolveTechnique technique = wing ? TECH_ALS_XY_WING : TECH_ALS_XZ;
+    int changed = 0;
+    AlmostLockedSetIndex<Box>& index = alsIndex.Get();
+    FindAlmostLockedSets(*this, index);
+    const AlmostLockedSet<Box>* sets = index.sets;
+
+    // Remove the values in shared from every open cell that sees each of
+    // their places in a and b
+    auto eliminate = [&](const AlmostLockedSet<Box>& a, const AlmostLockedSet<Box>& b, Mask shared) {
+        bool madeChange = false;
+        for(Mask rest = shared; rest; rest &= rest - 1) {
+            int z = LowestBit(rest);
+            ForEachCell<CELLS>({ &index.SeesAll(a, z), &index.SeesAll(b, z) }, [&](int cell) {
+                Mask mask = board.cells[cell];
+                if(!((mask >> z) & 1) || !(mask & (mask - 1))) return;
+                EliminatePossibility(cell / N, cell % N, z);
+                madeChange = true;
+                Trace(TRACE_ELIMINATE, technique, cell, z, "sees the value in both sets", a.cells[0]);
+            });
+        }
+        if(madeChange) changed++;
     };
 
-    // For each candidate value
-    for(int val = 0; val < 9; val++) {
-        // Find all cells that have this candidate
-        std::vector<std::pair<int, int>> candidateCells;
-        for(int row = 0; row < 9; row++) {
-            for(int col = 0; col < 9; col++) {
-                auto candidates = getCandidates(row, col);
-                if(std::find(candidates.begin(), candidates.end(), val) != candidates.end()) {
-                    candidateCells.push_back({row, col});
-                }
+    if(!wing) {
+        for(int i = 0; i < index.count; i++) {
+            for(int j = i + 1; j < index.count; j++) {
+                // The sets need a value to share besides x
+                Mask both = sets[i].values & sets[j].values;
+                if(!(both & (both - 1))) continue;
+                Mask restricted = RestrictedCommon(index, sets[i], sets[j]);
+                if(!restricted) continue;
+                Mask x = restricted & (~restricted + 1);
+                Mask shared = both & ~x;
+                Trace(TRACE_PATTERN, technique, sets[i].cells[0], LowestBit(x),
+                      "restricted common value", sets[j].cells[0]);
+                eliminate(sets[i], sets[j], shared);
             }
         }
+        return changed;
+    }
 
-        // For each starting cell, try to build a chain
-        for(const auto& start : candidateCells) {
-            std::vector<ColoredCell> chain;
-            std::vector<std::vector<bool>> visited(9, std::vector<bool>(9, false));
-            
-            // Start with the first cell colored as true
-            chain.emplace_back(start.first, start.second, true);
-            visited[start.first][start.second] = true;
-
-            bool chainChanged;
-            do {
-                chainChanged = false;
-                
-                // Look for cells that can extend the chain
-                for(const auto& cell : chain) {
-                    for(const auto& candidate : candidateCells) {
-                        int row = candidate.first;
-                        int col = candidate.second;
-                        
-                        if(!visited[row][col] && canSee(cell.row, cell.col, row, col)) {
-                            // Add cell with opposite color
-                            chain.emplace_back(row, col, !cell.color);
-                            visited[row][col] = true;
-                            chainChanged = true;
-                        }
-                    }
-                }
-            } while(chainChanged);
-
-            // Check for chain-based eliminations
-            if(chain.size() >= 2) {
-                // Check for same-colored cells that can see each other
-                for(size_t i = 0; i < chain.size(); i++) {
-                    for(size_t j = i + 1; j < chain.size(); j++) {
-                        if(chain[i].color == chain[j].color && 
-                           canSee(chain[i].row, chain[i].col, chain[j].row, chain[j].col)) {
-                            // Invalid coloring - can eliminate this candidate from all cells of the opposite color
-                            bool madeChange = false;
-                            int backup[9][9][9];
-                            memcpy(backup, board, sizeof(backup));
-
-                            for(const auto& cell : chain) {
-                                if(cell.color != chain[i].color) {
-                                    board[cell.row][cell.col][val] = -1;
-                                    madeChange = true;
-                                }
-                            }
-
-                            // Validate changes
-                            if(madeChange) {
-                                if(!IsValidSolution()) {
-                                    memcpy(board, backup, sizeof(backup));
-                                } else {
-                                    changed++;
-                                    print_debug("Simple Coloring: eliminated %d from opposite colored cells\n", 
-                                              val + 1);
-                                }
-                            }
-                        }
-                    }
+    // The restricted common values of every linked pair, then the same
+    // links from each side, counted into place
+    index.pairCount = 0;
+    for(int i = 0; i <= index.count; i++) index.offsets[i] = 0;
+    for(int i = 0; i < index.count; i++) {
+        for(int j = i + 1; j < index.count && index.pairCount < AlmostLockedSetIndex<Box>::MAX_PAIRS; j++) {
+            Mask restricted = RestrictedCommon(index, sets[i], sets[j]);
+            if(!restricted) continue;
+            index.pairs[index.pairCount][0] = i;
+            index.pairs[index.pairCount][1] = j;
+            index.pairCommon[index.pairCount++] = restricted;
+            index.offsets[i + 1]++;
+            index.offsets[j + 1]++;
+        }
+    }
+    for(int i = 0; i < index.count; i++) index.offsets[i + 1] += index.offsets[i];
+    for(int k = 0; k < index.pairCount; k++) {
+        for(int side = 0; side < 2; side++) {
+            // offsets[set] runs ahead while filling and ends where the
+            // next set starts, so it is stepped back below
+            int at = index.offsets[index.pairs[k][side]]++;
+            index.linked[at] = index.pairs[k][1 - side];
+            index.common[at] = index.pairCommon[k];
+        }
+    }
+    for(int i = index.count; i > 0; i--) index.offsets[i] = index.offsets[i - 1];
+    index.offsets[0] = 0;
+
+    for(int pivot = 0; pivot < index.count; pivot++) {
+        for(int i = index.offsets[pivot]; i < index.offsets[pivot + 1]; i++) {
+            for(int j = i + 1; j < index.offsets[pivot + 1]; j++) {
+                // Pick x and y apart; with one value each they must differ
+                Mask xs = index.common[i], ys = index.common[j];
+                Mask x = xs & (~xs + 1), y = ys & ~x;
+                if(!y) {
+                    y = ys;
+                    x = xs & ~y;
+                    if(!x) continue;
                 }
+                x &= ~x + 1;
+                y &= ~y + 1;
 
-                // Check for cells that can see both colors
-                for(int row = 0; row < 9; row++) {
-                    for(int col = 0; col < 9; col++) {
-                        if(visited[row][col]) continue;
+                const AlmostLockedSet<Box>& a = sets[index.linked[i]];
+                const AlmostLockedSet<Box>& b = sets[index.linked[j]];
+                Mask shared = a.values & b.values & ~(x | y);
+                if(!shared) continue;
+                Trace(TRACE_PATTERN, technique, sets[pivot].cells[0], LowestBit(x), "pivot set", a.cells[0]);
+                eliminate(a, b, shared);
+            }
+        }
+    }
 
-                        bool seesColor1 = false;
-                        bool seesColor2 = false;
+    return changed;
+}
 
-                        for(const auto& cell : chain) {
-                            if(canSee(row, col, cell.row, cell.col)) {
-                                if(cell.color) seesColor1 = true;
-                                else seesColor2 = true;
-                            }
-                        }
+template<int Box>
+int BasicSudoku<Box>::FindAlsXZ() {
+    return FindAls(false);
+}
 
-                        // If cell sees both colors, we can eliminate the candidate
-                        if(seesColor1 && seesColor2 && board[row][col][val] == val) {
-                            int backup[9][9][9];
-                            memcpy(backup, board, sizeof(backup));
-
-                            board[row][col][val] = -1;
-
-                            // Validate change
-                            if(!IsValidSolution()) {
-                                memcpy(board, backup, sizeof(backup));
-                            } else {
-                                changed++;
-                                print_debug("Simple Coloring: eliminated %d from (%d,%d) - sees both colors\n", 
-                                          val + 1, row + 1, col + 1);
-                            }
-                        }
-                    }
-                }
+template<int Box>
+int BasicSudoku<Box>::FindAlsXYWing() {
+    return FindAls(true);
+}
+
+// Nishio: assume a candidate, place the singles that follow on the board
+// and roll them back through the journal. A candidate whose singles run
+// into a contradiction is eliminated. Cells with the fewest candidates are
+// tried first. The work is bounded so the technique stays far cheaper than
+// a full search: at most TRIAL_ROUNDS sweeps for hidden singles per trial,
+// naked singles following through propagation, and TRIAL_LIMIT trials per
+// pass.
+template<int Box>
+int BasicSudoku<Box>::FindNishio() {
+    const int TRIAL_ROUNDS = 8;
+    const int TRIAL_LIMIT = 4 * CELLS;
+    int changed = 0;
+    int trials = 0;
+
+    bool previous = propagation;
+    SetPropagation(true);
+    if(!board.synced) StdElim();
+
+    for(int count = 2; count <= N && trials < TRIAL_LIMIT; count++) {
+        for(int cell = 0; cell < CELLS && trials < TRIAL_LIMIT; cell++) {
+            Mask cands = board.cells[cell];
+            if(BitCount(cands) != count) continue;
+
+            for(Mask rest = cands; rest && trials < TRIAL_LIMIT; rest &= rest - 1) {
+                // An earlier elimination may have solved the cell or taken
+                // this candidate through propagation; the rest still get tried
+                int val = LowestBit(rest);
+                if(MaskValue(board.cells[cell]) >= 0) break;
+                if(!((board.cells[cell] >> val) & 1)) continue;
+                trials++;
+
+                // The trial's writes are undone, so keep them out of the profile
+                bool synced = board.synced;
+                long long eliminated = eliminations, placed = placements;
+                size_t mark = Mark();
+                WriteCell(cell, Mask(1) << val);
+                bool consistent = SearchSingles(TRIAL_ROUNDS);
+                Rollback(mark);
+                Commit();
+                board.synced = synced;
+                eliminations = eliminated;
+                placements = placed;
+                if(consistent) continue;
+
+                EliminatePossibility(cell / N, cell % N, val);
+                changed++;
+                Trace(TRACE_ELIMINATE, TECH_NISHIO, cell, val, "placing it leads to a contradiction");
             }
         }
     }
 
+    SetPropagation(previous);
     return changed;
 }
 
+template class BasicSudoku<3>;
+template class BasicSudoku<4>;
+template class BasicSudoku<5>;
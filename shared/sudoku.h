@@ -22,30 +22,308 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <type_traits>
+#include <initializer_list>
 using std::string;
 
-class Sudoku {
+// Techniques Solve() can run, listed in the default order: cheapest first
+enum SolveTechnique {
+    TECH_STD_ELIM,
+    TECH_LINE_ELIM,
+    TECH_HIDDEN_SINGLES,
+    TECH_HIDDEN_PAIRS,
+    TECH_POINTING_PAIRS,
+    TECH_X_WING,
+    TECH_SWORDFISH,
+    TECH_JELLYFISH,
+    TECH_NAKED_SETS,
+    TECH_HIDDEN_SETS,
+    TECH_XY_WING,
+    TECH_XYZ_WING,
+    TECH_FINNED_FISH,
+    TECH_SIMPLE_COLORING,
+    TECH_CHAINS,
+    TECH_ALS_XZ,
+    TECH_ALS_XY_WING,
+    TECH_NISHIO,
+    TECH_COUNT
+};
+
+// The techniques a Solve() call runs and their order; each appears at most
+// once. With RESTART_CHEAPEST, progress from any technique sends the solver
+// back to the first in the list. With CONTINUE it carries on down the list
+// and wraps around. Either way the solve only stops once every listed
+// technique has run without progress since the last change.
+//
+// An adaptive pipeline orders each round by the progress per nanosecond
+// measured over every Solve() that used it. A batch that reuses one pipeline
+// learns to try the productive techniques first and the rarely useful ones
+// last.
+class SolvePipeline {
 public:
+    enum RestartPolicy { RESTART_CHEAPEST, CONTINUE };
+
+    SolvePipeline();    // every technique in default order
+    SolvePipeline(std::initializer_list<SolveTechnique> techniques,
+                  RestartPolicy policy = RESTART_CHEAPEST);
+
+    void Clear();
+    void Add(SolveTechnique technique);     // append, or move to the end if present
+    void Remove(SolveTechnique technique);
+    bool Contains(SolveTechnique technique) const;
+    int Size() const { return count; }
+    SolveTechnique At(int index) const { return order[index]; }
+
+    void SetRestartPolicy(RestartPolicy policy) { restart = policy; }
+    RestartPolicy GetRestartPolicy() const { return restart; }
+
+    void SetAdaptive(bool enabled) { adaptive = enabled; }
+    bool IsAdaptive() const { return adaptive; }
+    void ResetStatistics();
+    void Record(SolveTechnique technique, bool progress, long long nanoseconds);
+
+    // Fills run with the order for the next round, Size() entries
+    void Schedule(SolveTechnique (&run)[TECH_COUNT]) const;
+
+    static const char* Name(SolveTechnique technique);
+    static double Difficulty(SolveTechnique technique);    // Sudoku Explainer scale
+
+private:
+    SolveTechnique order[TECH_COUNT];
+    int count;
+    RestartPolicy restart;
+
+    bool adaptive;
+    long long calls[TECH_COUNT];
+    long long hits[TECH_COUNT];
+    long long nanoseconds[TECH_COUNT];
+};
+
+// Running totals for one technique, kept by RunTechnique(). Eliminated
+// counts candidates removed during the technique's calls, including those
+// removed by propagating its placements.
+struct TechniqueStats {
+    long long calls;
+    long long successes;     // calls that made progress
+    long long eliminated;
+    long long placed;
+    long long nanoseconds;
+};
+
+// Difficulty of a puzzle, found by replaying the solve with the easiest
+// technique that makes progress at each step. A puzzle scores its hardest
+// step, as in Sudoku Explainer. One the techniques can't finish scores
+// UNSOLVED_SCORE, above every technique.
+const double UNSOLVED_SCORE = 10.0;
+
+struct Rating {
+    bool solved;                // the techniques finished the grid
+    SolveTechnique hardest;     // hardest technique used, TECH_COUNT if none was needed
+    double score;               // Difficulty() of that technique, 0 if none, UNSOLVED_SCORE if unsolved
+    int steps[TECH_COUNT];      // passes of each technique that made progress
+};
+
+// Level of the solving trace. 0 compiles the trace out, 1 records
+// placements and eliminations, and 2 adds the patterns found, a summary of
+// every technique pass and the placements of SolveSingles(). Release
+// (NDEBUG) builds default to 0.
+#ifndef SUDOKU_TRACE_LEVEL
+#ifdef NDEBUG
+#define SUDOKU_TRACE_LEVEL 0
+#else
+#define SUDOKU_TRACE_LEVEL 1
+#endif
+#endif
+
+enum TraceKind {
+    TRACE_PLACE,        // value placed in cell
+    TRACE_ELIMINATE,    // value removed from the candidates of cell
+    TRACE_PATTERN,      // pattern on value found around cell (level 2)
+    TRACE_PASS          // technique pass finished, value is its result (level 2)
+};
+
+// One step of a solve. Cells are numbered x * N + y; reason is static text
+// and source the cell the step follows from, when there is one.
+struct TraceEvent {
+    unsigned char kind;         // TraceKind
+    unsigned char technique;    // SolveTechnique
+    short cell;
+    short value;
+    short source;
+    const char* reason;
+};
+
+// Ring of the most recent trace events. Once full, each new event
+// overwrites the oldest.
+class TraceBuffer {
+public:
+    static const int CAPACITY = 256;
+
+    TraceBuffer() : start(0), count(0), dropped(0) {}
+
+    void Push(const TraceEvent& event) {
+        if (count == CAPACITY) {
+            start = (start + 1) % CAPACITY;
+            count--;
+            dropped++;
+        }
+        events[(start + count++) % CAPACITY] = event;
+    }
+    int Size() const { return count; }
+    const TraceEvent& At(int index) const { return events[(start + index) % CAPACITY]; }  // 0 is the oldest
+    long long Dropped() const { return dropped; }
+    void Clear() { start = count = 0; dropped = 0; }
+
+private:
+    TraceEvent events[CAPACITY];
+    int start;
+    int count;
+    long long dropped;
+};
+
+// Working storage a solver keeps for a search. The solver allocates it up
+// front, so solving never has to. A copy gets fresh storage of its own,
+// without the contents, and never shares the original's.
+template<class T>
+class Scratch {
+public:
+    Scratch() : data(nullptr), create(nullptr), destroy(nullptr) {}
+    Scratch(const Scratch& other) : Scratch() { Follow(other); }
+    Scratch& operator=(const Scratch& other) { Follow(other); return *this; }
+    ~Scratch() { if (data) destroy(data); }
+
+    // Call where T is complete: the factories are made here
+    void Allocate() {
+        if (!data) {
+            create = []() { return new T; };
+            destroy = [](T* p) { delete p; };
+            data = create();
+        }
+    }
+    T& Get() { Allocate(); return *data; }
+
+private:
+    void Follow(const Scratch& other) {
+        if (!data && other.data) {
+            create = other.create;
+            destroy = other.destroy;
+            data = create();
+        }
+    }
+
+    T* data;
+    T* (*create)();
+    void (*destroy)(T*);
+};
+
+template<int Box> struct AlmostLockedSetIndex;
+template<int Box> struct ChainIndex;
+template<int Box> struct SearchTrail;
+
+// Solver engine for a grid of Box x Box boxes: 9x9 for Box 3, 16x16 for 4
+// and 25x25 for 5. The candidate masks use the narrowest integer that holds
+// one bit per value. Definitions live in sudoku.cpp, which instantiates
+// Box 3, 4 and 5.
+template<int Box>
+class BasicSudoku {
+public:
+    static const int N = Box * Box;         // values, and cells per unit
+    static const int CELLS = N * N;
+    static const int UNITS = 3 * N;
+
+    typedef typename std::conditional<(N <= 16), unsigned short,
+            typename std::conditional<(N <= 32), unsigned int,
+                                      unsigned long long>::type>::type Mask;
+    static const Mask ALL_CANDIDATES = Mask(~0ULL >> (64 - N));
+
+    // Candidate state of the grid. Each cell holds a mask where bit v is set
+    // while value v is still possible; a cell with exactly one bit left is
+    // solved. Units are numbered rows 0..N-1, columns N..2N-1, then boxes.
+    // counts[] tracks how often each value is placed in a unit, used[] the
+    // same as a mask, and conflicts the number of duplicate placements.
+    struct Board {
+        Mask cells[CELLS];
+        Mask used[UNITS];
+        unsigned char counts[UNITS][N];
+        int conflicts;
+        int filled;     // cells holding a single value
+        bool synced;    // every placed value has been removed from its peers
+    };
+
     // Constructor and Destructor
-    Sudoku();
-    ~Sudoku();
+    BasicSudoku();
+    virtual ~BasicSudoku();
 
     // Core Game Functions
     int SetValue(int x, int y, int value);
     int GetValue(int x, int y);
     int ClearValue(int x, int y);
+    bool IsCandidate(int x, int y, int value);
+    Mask GetCandidates(int x, int y);
+    // Effective candidates of cell x * N + y: its mask less any value a peer
+    // holds. Read from the unit masks WriteCell keeps current, so it costs
+    // three loads; filled cells have none.
+    Mask CellCandidates(int cell);
     void NewGame();
     bool LoadFromFile(const std::string& filename);
     void SaveToFile(const std::string& filename);
     
     // Main Solving Functions
-    int Solve();
+    int Solve();    // SolveSingles(), then the default pipeline if needed
+    int Solve(SolvePipeline& pipeline);     // updates an adaptive pipeline's statistics
+    int RunTechnique(SolveTechnique technique);    // one pass of a single technique
     int SolveBasic();
+    Rating Rate();      // leaves the board and profile as they were
+
+    // Naked and hidden singles only, on local bitmasks written back to the
+    // board once at the end: no printing or allocation, and traced only at
+    // SUDOKU_TRACE_LEVEL 2. Returns true once the grid is full. The singles found are kept when it stalls;
+    // on a contradiction the board is left as it was. Profiled as one call
+    // each of standard elimination and hidden singles.
+    bool SolveSingles();
     bool LegalValue(int x, int y, int value);
+
+    // Exact-cover (Dancing Links) backend working from the placed values.
+    // CountSolutions() stops once it reaches limit; SolveExact() fills the
+    // board with the first solution and returns false if there is none.
+    int CountSolutions(int limit);
+    bool SolveExact();
+    bool IsSolved();
+
+    // With propagation on, each placement is removed from its peers as soon
+    // as it is made and any naked singles that creates are placed in turn.
+    // Solve() and SolveBasic() turn it on for the duration of the solve.
+    void SetPropagation(bool enabled);
+
+    // When the techniques in Solve() stall, finish the grid with a
+    // depth-first search instead of returning it partly filled. Off by default.
+    void SetSearchFallback(bool enabled);
+
+    // Journal of candidate changes for speculative work. Mark() starts
+    // recording and returns a point Rollback() can restore, touching only the
+    // cells changed since. Every Mark() is paired with a Commit(); marks nest,
+    // and the journal is dropped once the outermost one is committed.
+    size_t Mark();
+    void Rollback(size_t mark);
+    void Commit();
     
     // Debug and Logging
     void LogBoard(std::ofstream& file, const char* algorithm_name);
-    void print_debug(const char* format, ...);
+    virtual void print_debug(const char* format, ...);
+
+    // The trace of recent solving steps, see SUDOKU_TRACE_LEVEL. Front ends
+    // format only the events they show: ShowTrace() passes the latest limit
+    // of them to print_debug and empties the buffer.
+    const TraceBuffer& GetTrace() const { return trace; }
+    void ClearTrace() { trace.Clear(); }
+    int FormatTraceEvent(const TraceEvent& event, char* buffer, int size);
+    void ShowTrace(int limit);
+
+    // Profile of every technique run through RunTechnique(), which includes
+    // all of Solve() and SolveBasic(), with SolveSingles() booked under the
+    // singles techniques. Kept until reset, across games.
+    const TechniqueStats& GetTechniqueStats(SolveTechnique technique) const { return stats[technique]; }
+    void ResetTechniqueStats();
 
    // Basic Solving Techniques
     int StdElim();           // Standard elimination
@@ -53,47 +331,99 @@ public:
     int FindHiddenSingles(); // Hidden singles technique
 
     // Advanced Solving Techniques
+    int FindSubsets(int minSize, int maxSize, bool hidden);  // naked or hidden subsets of 2-4 cells
     int FindHiddenPairs();      // Hidden pairs technique
+    int FindHiddenSets();       // Hidden triples and quads
     int FindPointingPairs();    // Pointing pairs technique
     int FindNakedSets();        // Naked sets (pairs/triples/quads)
-    void FindNakedSetInUnit(std::vector<std::pair<int, int>>& cells, 
-                           const std::vector<int>& candidates, 
-                           int& changed);
 
     // Expert Solving Techniques
+    int FindFish(int size, bool finned);    // basic or finned fish on 2-4 lines
     int FindXWing();           // X-Wing pattern
     int FindSwordFish();       // Swordfish pattern
+    int FindJellyfish();       // Jellyfish pattern
+    int FindFinnedFish();      // Finned and sashimi fish of every size
     int FindXYWing();          // XY-Wing pattern
     int FindXYZWing();         // XYZ-Wing pattern
     int FindSimpleColoring();  // Simple coloring technique
+    int FindChains();          // Alternating inference chains
+    int FindAls(bool wing);    // ALS-XZ or ALS-XY-Wing on almost locked sets
+    int FindAlsXZ();           // ALS-XZ pattern
+    int FindAlsXYWing();       // ALS-XY-Wing pattern
+    int FindNishio();          // Trial of each candidate with singles, bounded
     int Clean();
     bool IsValidSolution();
-    int board[9][9][9];
+    Board board;
 
     void ExportToExcelXML(const string& filename);
-    
-    #ifdef _WIN32
-    DebugQueue debugQueue;
-    char* get_next_debug_message();
-    #endif
-    
-
 
 private:
-    static int debug_line;
+    bool propagation;
+    int pending[CELLS];     // placements waiting to be removed from their peers
+    int pendingCount;
+
+    TraceBuffer trace;
+    void Trace(TraceKind kind, SolveTechnique technique, int cell, int value,
+               const char* reason = nullptr, int source = -1)
+    {
+        if (SUDOKU_TRACE_LEVEL >= (kind >= TRACE_PATTERN ? 2 : 1)) {
+            TraceEvent event = { (unsigned char)kind, (unsigned char)technique, (short)cell,
+                                 (short)value, (short)source, reason };
+            trace.Push(event);
+        }
+    }
+
+    TechniqueStats stats[TECH_COUNT];
+    long long eliminations;     // candidates removed by WriteCell, ever
+    long long placements;       // cells WriteCell left with a new single value
+
+    bool searchFallback;
+    bool trailing;          // WriteCell records the previous mask in trail
+    int marks;              // Mark() calls not yet committed
+    Scratch<SearchTrail<Box>> trail;
+    int trailSize;
+
+    // Fixed storage for the ALS index and the chain search, reused by every
+    // pass
+    Scratch<AlmostLockedSetIndex<Box>> alsIndex;
+    Scratch<ChainIndex<Box>> chainIndex;
+
+    // places[unit][v] is the number of open cells in the unit that can still
+    // take v, refreshed by CountPlaces() for the unit scanning techniques
+    unsigned char places[UNITS][N];
+    void CountPlaces();
+
+    int ExactCover(int limit, bool fill);
+    int RunSearch();
+    bool Search();
+    bool SearchSingles(int rounds = CELLS);
+    int RunSolve(SolvePipeline& pipeline);
+    int RunSolveBasic();
+    bool RunSolveSingles(int (&placed)[2]);
+    int Propagate();
 
     // Board Manipulation Functions
     int EliminatePossibility(int x, int y, int value);
-    void RestoreBoard(int original_board[9][9][9], int board[9][9][9]);
+    void WriteCell(int cell, Mask mask);
 
     // Validation Functions
     bool IsValidUnit(std::vector<int>& values);
+    bool VerifySolution();      // full rescan, used to check the counters in DEBUG builds
 
-    // Candidate Management
-    std::vector<int> GetCellCandidates(int x, int y);
-    bool VectorsEqual(const std::vector<int>& v1, const std::vector<int>& v2);
+};
 
- 
+// The standard 9x9 game, with debug output going to the platform's console
+class Sudoku : public BasicSudoku<3> {
+public:
+    void print_debug(const char* format, ...) override;
+
+    #ifdef _WIN32
+    DebugQueue debugQueue;
+    char* get_next_debug_message();
+    #endif
+
+private:
+    static int debug_line;
 };
 
 #endif // SUDOKU_H
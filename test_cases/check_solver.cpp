@@ -0,0 +1,189 @@
+// Regression checks for the solving engine, run by "make check" in
+// linux_cli. Exits non-zero if any check fails.
+//
+// corpus.txt holds one puzzle per line, 81 characters with '.' or '0' for
+// blanks. For each puzzle with a unique solution, every technique is run
+// until it stalls and must never remove a candidate of the solution, and
+// Solve() and SolveSingles() must agree with SolveExact().
+//
+// Each fixture is a grid in the usual 9-line format. The checker solves it
+// with every technique rated easier than the fixture's own, which must
+// then make progress and keep the solution's candidates. Lines such as
+// "r1c8<>4" after the grid name candidates the technique has to remove.
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "sudoku.h"
+
+void Sudoku::print_debug(const char*, ...) {}
+
+struct Fixture {
+    const char* file;
+    SolveTechnique technique;
+};
+
+static const Fixture FIXTURES[] = {
+    {"basicxwing.txt", TECH_X_WING},
+    {"swordfish.txt", TECH_SWORDFISH},
+    {"finnedfish.txt", TECH_FINNED_FISH},
+    {"coloring.txt", TECH_SIMPLE_COLORING},
+    {"chains.txt", TECH_CHAINS},
+    {"hiddenpairs.txt", TECH_HIDDEN_PAIRS},
+    {"nakedsets.txt", TECH_NAKED_SETS},
+    {"xywing.txt", TECH_XY_WING},
+    {"xyzwing.txt", TECH_XYZ_WING},
+    {"alsxz.txt", TECH_ALS_XZ},
+    {"alsxywing.txt", TECH_ALS_XY_WING},
+    {"nishio.txt", TECH_NISHIO},
+    {"nishio_later.txt", TECH_NISHIO}
+};
+
+static int failures = 0;
+
+static void Fail(const char* what, const std::string& puzzle, const char* detail)
+{
+    printf("FAIL %s: %s %s\n", what, puzzle.c_str(), detail);
+    failures++;
+}
+
+// The first value placed differently from the solution, or -1
+static int Mismatch(Sudoku& sudoku, Sudoku& solution)
+{
+    for (int cell = 0; cell < 81; cell++) {
+        int value = sudoku.GetValue(cell / 9, cell % 9);
+        if (value >= 0 && value != solution.GetValue(cell / 9, cell % 9)) return cell;
+    }
+    return -1;
+}
+
+// The first cell that lost its solution value as a candidate, or -1
+static int LostCandidate(Sudoku& sudoku, Sudoku& solution)
+{
+    for (int cell = 0; cell < 81; cell++) {
+        if (!sudoku.IsCandidate(cell / 9, cell % 9, solution.GetValue(cell / 9, cell % 9))) return cell;
+    }
+    return -1;
+}
+
+static void CheckPuzzle(const std::string& line)
+{
+    Sudoku puzzle;
+    for (int i = 0; i < 81; i++) {
+        if (line[i] >= '1' && line[i] <= '9') puzzle.SetValue(i % 9, i / 9, line[i] - '1');
+    }
+    if (puzzle.CountSolutions(2) != 1) return;
+    Sudoku solution = puzzle;
+    solution.SolveExact();
+
+    // Each technique on its own, with singles in between to keep it going
+    char detail[64];
+    for (int technique = 0; technique < TECH_COUNT; technique++) {
+        Sudoku sudoku = puzzle;
+        sudoku.SetPropagation(true);
+        sudoku.StdElim();
+        for (int pass = 0; pass < 81; pass++) {
+            int singles = sudoku.FindHiddenSingles() + sudoku.LinElim();
+            int result = sudoku.RunTechnique(static_cast<SolveTechnique>(technique));
+            int cell = LostCandidate(sudoku, solution);
+            if (cell >= 0) {
+                snprintf(detail, sizeof(detail), "lost the solution at r%dc%d", cell % 9 + 1, cell / 9 + 1);
+                Fail(SolvePipeline::Name(static_cast<SolveTechnique>(technique)), line, detail);
+                break;
+            }
+            if (singles <= 0 && result <= 0) break;
+        }
+    }
+
+    Sudoku solved = puzzle;
+    if (solved.Solve() != 0 || Mismatch(solved, solution) >= 0) {
+        Fail("Solve()", line, "disagrees with SolveExact()");
+    }
+
+    Sudoku singles = puzzle;
+    bool full = singles.SolveSingles();
+    if (Mismatch(singles, solution) >= 0 || (full && !singles.IsSolved())) {
+        Fail("SolveSingles()", line, "disagrees with SolveExact()");
+    }
+}
+
+static void CheckFixture(const std::string& dir, const Fixture& fixture)
+{
+    std::string path = dir + "/" + fixture.file;
+    Sudoku puzzle;
+    if (!puzzle.LoadFromFile(path)) {
+        Fail("fixture", path, "could not be read");
+        return;
+    }
+    Sudoku solution = puzzle;
+    if (puzzle.CountSolutions(2) != 1 || !solution.SolveExact()) {
+        Fail("fixture", path, "has no unique solution");
+        return;
+    }
+
+    // Candidates the technique must remove, after the grid
+    std::vector<int> expected;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        int row, col, value;
+        if (sscanf(line.c_str(), "r%dc%d<>%d", &row, &col, &value) == 3) {
+            expected.push_back(((col - 1) * 9 + row - 1) * 9 + value - 1);
+        }
+    }
+
+    double difficulty = SolvePipeline::Difficulty(fixture.technique);
+    SolvePipeline easier;
+    easier.Clear();
+    for (int technique = 0; technique < TECH_COUNT; technique++) {
+        SolveTechnique easy = static_cast<SolveTechnique>(technique);
+        if (SolvePipeline::Difficulty(easy) < difficulty) easier.Add(easy);
+    }
+
+    Sudoku sudoku = puzzle;
+    sudoku.Solve(easier);
+    sudoku.SetPropagation(true);
+    const char* name = SolvePipeline::Name(fixture.technique);
+    if (sudoku.RunTechnique(fixture.technique) <= 0) {
+        Fail(name, path, "made no progress");
+    }
+    if (LostCandidate(sudoku, solution) >= 0) {
+        Fail(name, path, "lost the solution");
+    }
+    for (int candidate : expected) {
+        int cell = candidate / 9;
+        if (sudoku.IsCandidate(cell / 9, cell % 9, candidate % 9)) {
+            char detail[64];
+            snprintf(detail, sizeof(detail), "kept r%dc%d<>%d", cell % 9 + 1, cell / 9 + 1, candidate % 9 + 1);
+            Fail(name, path, detail);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "test_cases";
+
+    std::ifstream corpus(dir + "/corpus.txt");
+    if (!corpus.is_open()) {
+        printf("FAIL could not open %s/corpus.txt\n", dir.c_str());
+        return 1;
+    }
+    int puzzles = 0;
+    std::string line;
+    while (std::getline(corpus, line)) {
+        if (line.length() < 81) continue;
+        CheckPuzzle(line);
+        puzzles++;
+    }
+
+    int fixtures = sizeof(FIXTURES) / sizeof(FIXTURES[0]);
+    for (int i = 0; i < fixtures; i++) {
+        CheckFixture(dir, FIXTURES[i]);
+    }
+
+    printf("%d puzzles, %d fixtures, %d failures\n", puzzles, fixtures, failures);
+    return failures ? 1 : 0;
+}
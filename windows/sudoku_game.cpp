@@ -47,27 +47,17 @@ ref class SudokuWrapper {
   // Undo history system
   ref class BoardState {
    public:
-    array<int, 3>^ boardData;
+    array<System::Byte>^ boardData;
     
-    BoardState(int source[9][9][9]) {
-      boardData = gcnew array<int, 3>(9, 9, 9);
-      for (int x = 0; x < 9; x++) {
-        for (int y = 0; y < 9; y++) {
-          for (int z = 0; z < 9; z++) {
-            boardData[x, y, z] = source[x][y][z];
-          }
-        }
-      }
+    BoardState(const Sudoku::Board& source) {
+      boardData = gcnew array<System::Byte>(sizeof(Sudoku::Board));
+      pin_ptr<System::Byte> data = &boardData[0];
+      *reinterpret_cast<Sudoku::Board*>(static_cast<System::Byte*>(data)) = source;
     }
     
-    void CopyToBoard(int dest[9][9][9]) {
-      for (int x = 0; x < 9; x++) {
-        for (int y = 0; y < 9; y++) {
-          for (int z = 0; z < 9; z++) {
-            dest[x][y][z] = boardData[x, y, z];
-          }
-        }
-      }
+    void CopyToBoard(Sudoku::Board& dest) {
+      pin_ptr<System::Byte> data = &boardData[0];
+      dest = *reinterpret_cast<Sudoku::Board*>(static_cast<System::Byte*>(data));
     }
   };
   
@@ -923,6 +913,8 @@ public ref class MainForm : public System::Windows::Forms::Form {
   void UpdateDebugBox(Object^ sender, EventArgs^ e) {
     char* msg;
     System::Text::StringBuilder^ sb = gcnew System::Text::StringBuilder();
+    // Queue the solving steps recorded since the last poll
+    sudoku->NativeSudoku->ShowTrace(TraceBuffer::CAPACITY);
     while ((msg = sudoku->NativeSudoku->get_next_debug_message()) != nullptr) {
       sb->Append(gcnew String(msg));
       sb->Append("\r\n");
@@ -1394,8 +1386,9 @@ void CopyBoard_Click(Object^ sender, EventArgs^ e) {
   // Returns the correct value (0-8) for a cell by solving a copy, or -1 if unsolvable
   int GetCorrectValue(int row, int col) {
     Sudoku* copy = new Sudoku();
-    memcpy(copy->board, sudoku->NativeSudoku->board, sizeof(copy->board));
+    copy->board = sudoku->NativeSudoku->board;
     copy->Solve();
+    if (!copy->IsSolved()) copy->SolveExact();
     int val = copy->GetValue(row, col);
     delete copy;
     return val;
@@ -1404,8 +1397,9 @@ void CopyBoard_Click(Object^ sender, EventArgs^ e) {
   void HintCell() {
     // Solve a copy to find the answer, then place one random unknown cell
     Sudoku* copy = new Sudoku();
-    memcpy(copy->board, sudoku->NativeSudoku->board, sizeof(copy->board));
+    copy->board = sudoku->NativeSudoku->board;
     copy->Solve();
+    if (!copy->IsSolved()) copy->SolveExact();
 
     // Collect all empty cells
     System::Collections::Generic::List<array<int>^>^ emptyCells =
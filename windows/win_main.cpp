@@ -43,27 +43,17 @@ ref class SudokuWrapper {
   // Undo history system
   ref class BoardState {
    public:
-    array<int, 3>^ boardData;
+    array<System::Byte>^ boardData;
     
-    BoardState(int source[9][9][9]) {
-      boardData = gcnew array<int, 3>(9, 9, 9);
-      for (int x = 0; x < 9; x++) {
-        for (int y = 0; y < 9; y++) {
-          for (int z = 0; z < 9; z++) {
-            boardData[x, y, z] = source[x][y][z];
-          }
-        }
-      }
+    BoardState(const Sudoku::Board& source) {
+      boardData = gcnew array<System::Byte>(sizeof(Sudoku::Board));
+      pin_ptr<System::Byte> data = &boardData[0];
+      *reinterpret_cast<Sudoku::Board*>(static_cast<System::Byte*>(data)) = source;
     }
     
-    void CopyToBoard(int dest[9][9][9]) {
-      for (int x = 0; x < 9; x++) {
-        for (int y = 0; y < 9; y++) {
-          for (int z = 0; z < 9; z++) {
-            dest[x][y][z] = boardData[x, y, z];
-          }
-        }
-      }
+    void CopyToBoard(Sudoku::Board& dest) {
+      pin_ptr<System::Byte> data = &boardData[0];
+      dest = *reinterpret_cast<Sudoku::Board*>(static_cast<System::Byte*>(data));
     }
   };
   
@@ -842,6 +832,8 @@ public ref class MainForm : public System::Windows::Forms::Form {
   void UpdateDebugBox(Object^ sender, EventArgs^ e) {
     char* msg;
     System::Text::StringBuilder^ sb = gcnew System::Text::StringBuilder();
+    // Queue the solving steps recorded since the last poll
+    sudoku->NativeSudoku->ShowTrace(TraceBuffer::CAPACITY);
     while ((msg = sudoku->NativeSudoku->get_next_debug_message()) != nullptr) {
       sb->Append(gcnew String(msg));
       sb->Append("\r\n");